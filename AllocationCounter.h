@@ -0,0 +1,53 @@
+// AllocationCounter.h - heap allocation counting for the benchmarks
+//
+// Replaces the global operator new / operator delete, so include it from
+// the one translation unit of a benchmark program and nowhere else. The
+// plain, align_val_t and nothrow scalar forms are replaced (sanitizers
+// supply their own nothrow forms otherwise, which do not pair with the
+// deletes here); the default array forms forward to them. Allocations
+// made by any thread are counted while countAllocations is set.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+inline std::atomic<bool> countAllocations{false};
+inline std::atomic<size_t> allocationCount{0};
+
+// Out of line so GCC does not pair malloc/free across inlined call sites
+__attribute__((noinline)) void* operator new(size_t size) {
+    if (countAllocations.load(std::memory_order_relaxed))
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+__attribute__((noinline)) void* operator new(size_t size, std::align_val_t al) {
+    if (countAllocations.load(std::memory_order_relaxed))
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    const size_t a = size_t(al);
+    if (void* p = std::aligned_alloc(a, (std::max<size_t>(size, 1) + a - 1) / a * a)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return ::operator new(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+void* operator new(size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    try {
+        return ::operator new(size, al);
+    } catch (...) {
+        return nullptr;
+    }
+}
+__attribute__((noinline)) void operator delete(void* p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
@@ -14,6 +14,26 @@ Provide detailed test cases demonstrating correct evaluations.*/
 #include <cctype>
 #include <stdexcept>
 #include <map>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <exception>
+#include <climits>
+#include <cstring>
+#include <tuple>
+#include <random>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <list>
+#include <atomic>
+#include <functional>
 using namespace std;
 
 // Operator precedence
@@ -83,6 +103,825 @@ double evaluate(const string& expr) {
     return values.top();
 }
 
+// ------------ Compiled programs ------------
+// compile() runs the same shunting-yard pass as evaluate() once, but emits
+// postfix instructions instead of computing. The program is a flat array
+// of 16-byte instructions that run() walks with a fixed-size stack on the
+// C++ stack, so evaluating never allocates. Identifiers become variable
+// slots that are bound to values at run time.
+// StoreTemp / LoadTemp only appear in optimized programs, where a common
+// subexpression is computed once, kept in a temp and reloaded.
+enum class OpCode : uint8_t { PushConst, PushVar, Add, Sub, Mul, Div, Neg, StoreTemp, LoadTemp };
+
+struct Instr {
+    OpCode op;
+    uint32_t slot;   // PushVar: variable slot; StoreTemp / LoadTemp: temp slot
+    double value;    // PushConst: literal
+};
+
+// Deepest value stack a program may need; deeper expressions fail to compile.
+// Also the limit on temps in an optimized program.
+const size_t MAX_STACK_DEPTH = 256;
+
+class Program {
+public:
+    const vector<Instr>& code() const { return instrs; }
+    const vector<string>& variables() const { return names; }
+    size_t stackDepth() const { return depth; }
+    size_t tempCount() const { return temps; }
+
+    // Slot of a variable, for binding values by position
+    size_t slotOf(const string& name) const {
+        for (size_t i = 0; i < names.size(); ++i)
+            if (names[i] == name) return i;
+        throw runtime_error("Unknown variable: " + name);
+    }
+
+    // vars[i] is the value of variables()[i]; may be null only when the
+    // expression has no variables
+    double run(const double* vars = nullptr) const {
+        if (vars == nullptr && !names.empty())
+            throw runtime_error("Expected " + to_string(names.size()) + " variable values");
+        double stack[MAX_STACK_DEPTH];
+        double temp[MAX_STACK_DEPTH];
+        size_t sp = 0;
+        for (const Instr& in : instrs) {
+            switch (in.op) {
+                case OpCode::PushConst: stack[sp++] = in.value; break;
+                case OpCode::PushVar:   stack[sp++] = vars[in.slot]; break;
+                case OpCode::Add: --sp; stack[sp - 1] += stack[sp]; break;
+                case OpCode::Sub: --sp; stack[sp - 1] -= stack[sp]; break;
+                case OpCode::Mul: --sp; stack[sp - 1] *= stack[sp]; break;
+                case OpCode::Div:
+                    --sp;
+                    if (stack[sp] == 0) throw runtime_error("Division by zero");
+                    stack[sp - 1] /= stack[sp];
+                    break;
+                case OpCode::Neg: stack[sp - 1] = -stack[sp - 1]; break;
+                case OpCode::StoreTemp: temp[in.slot] = stack[sp - 1]; break;
+                case OpCode::LoadTemp:  stack[sp++] = temp[in.slot]; break;
+            }
+        }
+        return stack[0];
+    }
+
+    double run(const vector<double>& vars) const {
+        if (vars.size() != names.size())
+            throw runtime_error("Expected " + to_string(names.size()) + " variable values");
+        return run(vars.data());
+    }
+
+    // Binds by name; convenient, but resolves every name on each call
+    double run(const map<string, double>& vars) const {
+        double values[MAX_STACK_DEPTH];
+        if (names.size() > MAX_STACK_DEPTH) throw runtime_error("Too many variables");
+        for (size_t i = 0; i < names.size(); ++i) {
+            auto it = vars.find(names[i]);
+            if (it == vars.end()) throw runtime_error("Unbound variable: " + names[i]);
+            values[i] = it->second;
+        }
+        return run(values);
+    }
+
+private:
+    friend Program compile(const string& expr);
+    friend class ExprGraph;
+
+    vector<Instr> instrs;
+    vector<string> names;
+    size_t depth = 0;
+    size_t temps = 0;
+};
+
+// Opcode for a binary operator character
+OpCode binaryOpCode(char op) {
+    switch (op) {
+        case '+': return OpCode::Add;
+        case '-': return OpCode::Sub;
+        case '*': return OpCode::Mul;
+        case '/': return OpCode::Div;
+    }
+    throw runtime_error("Unknown operator");
+}
+
+// Parses expr into a Program. Also accepts identifiers ([A-Za-z_][A-Za-z0-9_]*)
+// and unary minus / plus, and rejects malformed input instead of guessing.
+Program compile(const string& expr) {
+    Program prog;
+    stack<char> ops;           // '(' , binary operators, or '~' for unary minus
+    size_t sp = 0;             // simulated value stack height
+    bool expectOperand = true;
+
+    auto emit = [&](char op) {
+        if (op == '~') {
+            prog.instrs.push_back({OpCode::Neg, 0, 0.0});
+            return;
+        }
+        if (sp < 2) throw runtime_error("Malformed expression");
+        prog.instrs.push_back({binaryOpCode(op), 0, 0.0});
+        --sp;
+    };
+    auto push = [&](const Instr& in) {
+        prog.instrs.push_back(in);
+        if (++sp > MAX_STACK_DEPTH) throw runtime_error("Expression too deeply nested");
+        prog.depth = max(prog.depth, sp);
+    };
+
+    size_t i = 0;
+    while (i < expr.size()) {
+        char c = expr[i];
+        if (isspace(static_cast<unsigned char>(c))) {
+            ++i;
+        } else if (isdigit(static_cast<unsigned char>(c)) || c == '.') {
+            if (!expectOperand) throw runtime_error("Malformed expression");
+            const char* begin = expr.c_str() + i;
+            char* end;
+            double val = strtod(begin, &end);
+            if (end == begin) throw runtime_error("Invalid number");
+            i += size_t(end - begin);
+            push({OpCode::PushConst, 0, val});
+            expectOperand = false;
+        } else if (isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            if (!expectOperand) throw runtime_error("Malformed expression");
+            size_t start = i;
+            while (i < expr.size() && (isalnum(static_cast<unsigned char>(expr[i])) || expr[i] == '_')) ++i;
+            string name = expr.substr(start, i - start);
+            auto it = find(prog.names.begin(), prog.names.end(), name);
+            uint32_t slot = uint32_t(it - prog.names.begin());
+            if (it == prog.names.end()) prog.names.push_back(name);
+            push({OpCode::PushVar, slot, 0.0});
+            expectOperand = false;
+        } else if (c == '(') {
+            if (!expectOperand) throw runtime_error("Malformed expression");
+            ops.push(c);
+            ++i;
+        } else if (c == ')') {
+            if (expectOperand) throw runtime_error("Malformed expression");
+            while (!ops.empty() && ops.top() != '(') {
+                emit(ops.top());
+                ops.pop();
+            }
+            if (ops.empty()) throw runtime_error("Mismatched parentheses");
+            ops.pop();
+            ++i;
+        } else if (c == '+' || c == '-' || c == '*' || c == '/') {
+            ++i;
+            if (expectOperand) {
+                if (c == '-') ops.push('~');
+                else if (c != '+') throw runtime_error("Malformed expression");
+                continue;
+            }
+            while (!ops.empty() && ops.top() != '(' &&
+                   (ops.top() == '~' || precedence(ops.top()) >= precedence(c))) {
+                emit(ops.top());
+                ops.pop();
+            }
+            ops.push(c);
+            expectOperand = true;
+        } else {
+            throw runtime_error(string("Unexpected character '") + c + "'");
+        }
+    }
+    if (expectOperand) throw runtime_error("Malformed expression");
+    while (!ops.empty()) {
+        if (ops.top() == '(') throw runtime_error("Mismatched parentheses");
+        emit(ops.top());
+        ops.pop();
+    }
+    return prog;
+}
+
+// Postfix listing of a program, e.g. "x 2 * 1 +"
+string disassemble(const Program& prog) {
+    ostringstream out;
+    for (const Instr& in : prog.code()) {
+        if (&in != &prog.code().front()) out << ' ';
+        switch (in.op) {
+            case OpCode::PushConst: out << in.value; break;
+            case OpCode::PushVar:   out << prog.variables()[in.slot]; break;
+            case OpCode::Add: out << '+'; break;
+            case OpCode::Sub: out << '-'; break;
+            case OpCode::Mul: out << '*'; break;
+            case OpCode::Div: out << '/'; break;
+            case OpCode::Neg: out << "neg"; break;
+            case OpCode::StoreTemp: out << "=t" << in.slot; break;
+            case OpCode::LoadTemp:  out << 't' << in.slot; break;
+        }
+    }
+    return out.str();
+}
+
+// ------------ Optimizer ------------
+// ExprGraph lifts a program's postfix code into an expression DAG and
+// simplifies it while building: every node goes through a smart
+// constructor that folds constants and applies identities, then is
+// hash-consed, so structurally equal subexpressions become one node.
+// emit() turns the DAG back into bytecode, computing each shared node
+// once into a temp. Only rewrites that give bit-identical IEEE results
+// are made by default:
+//   c1 op c2 -> c (not x / 0, which must still throw at run time)
+//   x * 1, 1 * x, x / 1, x - 0, x + -0 -> x        x * -1, x / -1 -> -x
+//   -(-x) -> x    x - (-y) -> x + y    x + (-y), (-y) + x -> x - y
+//   x / c -> x * (1 / c) when c is a power of two (exact reciprocal)
+//   a + b, a * b share a node with b + a, b * a
+// Reassociation (2 * x * 3 -> 6 * x) and x * 0 -> 0 change results for
+// some inputs (rounding, inf, NaN) and are not done.
+struct OptimizeOptions {
+    // Also turn x / c into x * (1 / c) for any nonzero constant. Faster,
+    // but may differ from x / c in the last bit.
+    bool inexactReciprocal = false;
+};
+
+class ExprGraph {
+public:
+    explicit ExprGraph(const Program& prog, OptimizeOptions options = OptimizeOptions())
+        : options(options), names(prog.variables()) {
+        vector<int> stack;
+        vector<int> temp(prog.tempCount(), -1);
+        for (const Instr& in : prog.code()) {
+            switch (in.op) {
+                case OpCode::PushConst: stack.push_back(constant(in.value)); break;
+                case OpCode::PushVar:   stack.push_back(variable(in.slot)); break;
+                case OpCode::Neg:       stack.back() = negate(stack.back()); break;
+                case OpCode::StoreTemp: temp[in.slot] = stack.back(); break;
+                case OpCode::LoadTemp:  stack.push_back(temp[in.slot]); break;
+                default: {
+                    int b = stack.back();
+                    stack.pop_back();
+                    stack.back() = binary(in.op, stack.back(), b);
+                }
+            }
+        }
+        root = stack.back();
+    }
+
+    // Infix form of the simplified expression
+    string toString() const { return infix(root); }
+
+    // Nodes reachable from the root (shared subexpressions count once)
+    size_t nodeCount() const {
+        vector<int> uses(nodes.size(), 0);
+        countUses(root, uses);
+        return size_t(count_if(uses.begin(), uses.end(), [](int u) { return u > 0; }));
+    }
+
+    Program emit() const {
+        Program prog;
+        prog.names = names;
+        vector<int> uses(nodes.size(), 0);
+        countUses(root, uses);
+        vector<int> tempOf(nodes.size(), -1);
+        size_t sp = 0;
+        emitNode(root, uses, tempOf, prog, sp);
+        return prog;
+    }
+
+private:
+    struct Node {
+        OpCode op;       // PushConst, PushVar, Neg or a binary operator
+        uint32_t slot;
+        double value;
+        int lhs, rhs;
+    };
+
+    OptimizeOptions options;
+    vector<string> names;
+    vector<Node> nodes;
+    map<tuple<int, uint64_t, uint32_t, int, int>, int> interned;
+    int root = -1;
+
+    // Commutative operators are looked up with their operands in a
+    // canonical order, so b + a finds a + b; the node itself keeps the
+    // order it was first built with, which keeps left-deep chains left-deep
+    int intern(const Node& n) {
+        uint64_t bits;
+        memcpy(&bits, &n.value, sizeof(bits));
+        int l = n.lhs, r = n.rhs;
+        if ((n.op == OpCode::Add || n.op == OpCode::Mul) && r < l) swap(l, r);
+        auto key = make_tuple(int(n.op), bits, n.slot, l, r);
+        auto it = interned.find(key);
+        if (it != interned.end()) return it->second;
+        nodes.push_back(n);
+        interned.emplace(key, int(nodes.size() - 1));
+        return int(nodes.size() - 1);
+    }
+
+    int constant(double v) { return intern({OpCode::PushConst, 0, v, -1, -1}); }
+    int variable(uint32_t slot) { return intern({OpCode::PushVar, slot, 0.0, -1, -1}); }
+
+    bool isConst(int id) const { return nodes[id].op == OpCode::PushConst; }
+
+    // Exact bit-level match, so +0 and -0 are told apart
+    bool isConst(int id, double v) const {
+        return isConst(id) && memcmp(&nodes[id].value, &v, sizeof(double)) == 0;
+    }
+
+    bool isNeg(int id) const { return nodes[id].op == OpCode::Neg; }
+
+    int negate(int a) {
+        if (isConst(a)) return constant(-nodes[a].value);
+        if (isNeg(a)) return nodes[a].lhs;
+        return intern({OpCode::Neg, 0, 0.0, a, -1});
+    }
+
+    int binary(OpCode op, int a, int b) {
+        if (isConst(a) && isConst(b) && !(op == OpCode::Div && nodes[b].value == 0)) {
+            double x = nodes[a].value, y = nodes[b].value;
+            switch (op) {
+                case OpCode::Add: return constant(x + y);
+                case OpCode::Sub: return constant(x - y);
+                case OpCode::Mul: return constant(x * y);
+                default:          return constant(x / y);
+            }
+        }
+        switch (op) {
+            case OpCode::Add:
+                if (isConst(b, -0.0)) return a;
+                if (isConst(a, -0.0)) return b;
+                if (isNeg(b)) return binary(OpCode::Sub, a, nodes[b].lhs);
+                if (isNeg(a)) return binary(OpCode::Sub, b, nodes[a].lhs);
+                break;
+            case OpCode::Sub:
+                if (isConst(b, 0.0)) return a;
+                if (isNeg(b)) return binary(OpCode::Add, a, nodes[b].lhs);
+                break;
+            case OpCode::Mul:
+                if (isConst(b, 1.0)) return a;
+                if (isConst(a, 1.0)) return b;
+                if (isConst(b, -1.0)) return negate(a);
+                if (isConst(a, -1.0)) return negate(b);
+                break;
+            case OpCode::Div:
+                if (isConst(b, 1.0)) return a;
+                if (isConst(b, -1.0)) return negate(a);
+                if (isConst(b) && nodes[b].value != 0 && isfinite(nodes[b].value)) {
+                    int exponent;
+                    double mantissa = frexp(nodes[b].value, &exponent);
+                    double reciprocal = 1.0 / nodes[b].value;
+                    bool exact = fabs(mantissa) == 0.5 && isnormal(reciprocal);
+                    if (exact || options.inexactReciprocal)
+                        return binary(OpCode::Mul, a, constant(reciprocal));
+                }
+                break;
+            default: break;
+        }
+        return intern({op, 0, 0.0, a, b});
+    }
+
+    // The walks below use explicit stacks: graph depth grows with the
+    // length of the expression, not with the evaluation stack depth
+    void countUses(int root, vector<int>& uses) const {
+        vector<int> pending{root};
+        while (!pending.empty()) {
+            int id = pending.back();
+            pending.pop_back();
+            if (uses[id]++ > 0) continue;   // children already counted via the first use
+            if (nodes[id].rhs >= 0) pending.push_back(nodes[id].rhs);
+            if (nodes[id].lhs >= 0) pending.push_back(nodes[id].lhs);
+        }
+    }
+
+    void push(Program& prog, const Instr& in, size_t& sp) const {
+        prog.instrs.push_back(in);
+        if (++sp > MAX_STACK_DEPTH) throw runtime_error("Expression too deeply nested");
+        prog.depth = max(prog.depth, sp);
+    }
+
+    // Post-order: stage 0 visits a node, 1 follows its lhs, 2 its rhs
+    void emitNode(int root, const vector<int>& uses, vector<int>& tempOf, Program& prog, size_t& sp) const {
+        vector<pair<int, int>> pending{{root, 0}};
+        while (!pending.empty()) {
+            auto [id, stage] = pending.back();
+            pending.pop_back();
+            const Node& n = nodes[id];
+            if (stage == 0) {
+                if (tempOf[id] >= 0) {
+                    push(prog, {OpCode::LoadTemp, uint32_t(tempOf[id]), 0.0}, sp);
+                } else if (n.op == OpCode::PushConst || n.op == OpCode::PushVar) {
+                    push(prog, {n.op, n.slot, n.value}, sp);
+                } else {
+                    pending.push_back({id, 1});
+                    pending.push_back({n.lhs, 0});
+                }
+                continue;
+            }
+            if (stage == 1 && n.op != OpCode::Neg) {
+                pending.push_back({id, 2});
+                pending.push_back({n.rhs, 0});
+                continue;
+            }
+            prog.instrs.push_back({n.op, 0, 0.0});
+            if (n.op != OpCode::Neg) --sp;
+            if (uses[id] > 1) {
+                if (prog.temps == MAX_STACK_DEPTH) throw runtime_error("Too many common subexpressions");
+                tempOf[id] = int(prog.temps++);
+                prog.instrs.push_back({OpCode::StoreTemp, uint32_t(tempOf[id]), 0.0});
+            }
+        }
+    }
+
+    static int precedenceOf(const Node& n) {
+        switch (n.op) {
+            case OpCode::Add: case OpCode::Sub: return 1;
+            case OpCode::Mul: case OpCode::Div: return 2;
+            case OpCode::Neg: return 3;
+            case OpCode::PushConst: return signbit(n.value) ? 3 : 4;
+            default: return 4;
+        }
+    }
+
+    // Text of each node is built once its operands' text is ready and is
+    // moved into its last user, so a long chain is not copied per level
+    string infix(int root) const {
+        vector<int> remaining(nodes.size(), 0);
+        countUses(root, remaining);
+        vector<string> text(nodes.size());
+        vector<char> done(nodes.size(), 0);
+        auto take = [&](int id) -> string {
+            if (--remaining[id] == 0) return move(text[id]);
+            return text[id];
+        };
+        vector<int> pending{root};
+        while (!pending.empty()) {
+            const int id = pending.back();
+            const Node& n = nodes[id];
+            if (done[id]) {
+                pending.pop_back();
+                continue;
+            }
+            const size_t before = pending.size();
+            if (n.rhs >= 0 && !done[n.rhs]) pending.push_back(n.rhs);
+            if (n.lhs >= 0 && !done[n.lhs]) pending.push_back(n.lhs);
+            if (pending.size() != before) continue;
+            pending.pop_back();
+            done[id] = 1;
+            switch (n.op) {
+                case OpCode::PushConst: {
+                    ostringstream out;
+                    out.precision(15);
+                    out << n.value;
+                    text[id] = out.str();
+                    continue;
+                }
+                case OpCode::PushVar: text[id] = names[n.slot]; continue;
+                case OpCode::Neg: {
+                    string inner = take(n.lhs);
+                    text[id] = precedenceOf(nodes[n.lhs]) < 3 ? "-(" + inner + ")" : "-" + inner;
+                    continue;
+                }
+                default: break;
+            }
+            const int p = precedenceOf(n);
+            string l = take(n.lhs), r = take(n.rhs);
+            if (precedenceOf(nodes[n.lhs]) < p) l = "(" + l + ")";
+            // Right operands of - and / need parentheses at equal precedence too
+            const bool rightAssocSensitive = n.op == OpCode::Sub || n.op == OpCode::Div;
+            if (precedenceOf(nodes[n.rhs]) < p || (rightAssocSensitive && precedenceOf(nodes[n.rhs]) == p))
+                r = "(" + r + ")";
+            l += n.op == OpCode::Add ? " + " : n.op == OpCode::Sub ? " - " : n.op == OpCode::Mul ? " * " : " / ";
+            l += r;
+            text[id] = move(l);
+        }
+        return text[root];
+    }
+};
+
+Program optimize(const Program& prog, OptimizeOptions options = OptimizeOptions()) {
+    return ExprGraph(prog, options).emit();
+}
+
+// Simplified infix form, for checking what optimize() did
+string optimizedForm(const Program& prog, OptimizeOptions options = OptimizeOptions()) {
+    return ExprGraph(prog, options).toString();
+}
+
+// ------------ Batch evaluation ------------
+// Evaluates one program over columns of inputs: row r uses columns[s][r]
+// as the value of variable slot s. Rows are processed in blocks of
+// BATCH_BLOCK and every instruction runs over a whole block, so the
+// interpreter dispatch is paid once per block rather than once per row and
+// each operator is a plain unit-stride loop that the compiler vectorizes.
+const size_t BATCH_BLOCK = 256;
+
+// Rows per thread below which evaluateBatch() stays on the calling thread
+const size_t BATCH_ROWS_PER_THREAD = 1 << 15;
+
+// Evaluates rows [begin, end); scratch holds one block per stack level
+void evaluateRows(const Program& prog, const vector<const double*>& columns, double* out,
+                  size_t begin, size_t end, vector<double>& scratch) {
+    scratch.resize((max<size_t>(prog.stackDepth(), 1) + prog.tempCount()) * BATCH_BLOCK);
+    double* const blocks = scratch.data();
+    double* const temps = blocks + max<size_t>(prog.stackDepth(), 1) * BATCH_BLOCK;
+    for (size_t base = begin; base < end; base += BATCH_BLOCK) {
+        const size_t n = min(BATCH_BLOCK, end - base);
+        size_t sp = 0;
+        for (const Instr& in : prog.code()) {
+            if (in.op == OpCode::PushConst || in.op == OpCode::PushVar || in.op == OpCode::LoadTemp) {
+                double* dst = blocks + sp++ * BATCH_BLOCK;
+                if (in.op == OpCode::PushConst) fill(dst, dst + n, in.value);
+                else if (in.op == OpCode::PushVar) copy(columns[in.slot] + base, columns[in.slot] + base + n, dst);
+                else copy(temps + in.slot * BATCH_BLOCK, temps + in.slot * BATCH_BLOCK + n, dst);
+                continue;
+            }
+            if (in.op == OpCode::StoreTemp) {
+                const double* src = blocks + (sp - 1) * BATCH_BLOCK;
+                copy(src, src + n, temps + in.slot * BATCH_BLOCK);
+                continue;
+            }
+            if (in.op == OpCode::Neg) {
+                double* __restrict a = blocks + (sp - 1) * BATCH_BLOCK;
+                for (size_t k = 0; k < n; ++k) a[k] = -a[k];
+                continue;
+            }
+            --sp;
+            double* __restrict a = blocks + (sp - 1) * BATCH_BLOCK;
+            const double* __restrict b = blocks + sp * BATCH_BLOCK;
+            switch (in.op) {
+                case OpCode::Add: for (size_t k = 0; k < n; ++k) a[k] += b[k]; break;
+                case OpCode::Sub: for (size_t k = 0; k < n; ++k) a[k] -= b[k]; break;
+                case OpCode::Mul: for (size_t k = 0; k < n; ++k) a[k] *= b[k]; break;
+                case OpCode::Div: {
+                    bool zero = false;
+                    for (size_t k = 0; k < n; ++k) zero |= b[k] == 0;
+                    if (zero) {
+                        size_t row = base + size_t(find(b, b + n, 0.0) - b);
+                        throw runtime_error("Division by zero in row " + to_string(row));
+                    }
+                    for (size_t k = 0; k < n; ++k) a[k] /= b[k];
+                    break;
+                }
+                default: break;
+            }
+        }
+        copy(blocks, blocks + n, out + base);
+    }
+}
+
+// out[r] = prog evaluated on row r, for r < rows. columns[s] supplies the
+// values of prog.variables()[s]. Large batches are split into contiguous
+// row ranges across 'threads' threads (0 = hardware concurrency); if any
+// row divides by zero, the error from the lowest such range is rethrown.
+void evaluateBatch(const Program& prog, const vector<const double*>& columns, double* out,
+                   size_t rows, size_t threads = 0) {
+    if (columns.size() != prog.variables().size())
+        throw runtime_error("Expected " + to_string(prog.variables().size()) + " input columns");
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    threads = max<size_t>(1, min(threads, rows / BATCH_ROWS_PER_THREAD));
+
+    if (threads == 1) {
+        vector<double> scratch;
+        evaluateRows(prog, columns, out, 0, rows, scratch);
+        return;
+    }
+
+    vector<exception_ptr> errors(threads);
+    vector<thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        // Range boundaries are rounded to whole blocks
+        size_t begin = rows * t / threads / BATCH_BLOCK * BATCH_BLOCK;
+        size_t end = t + 1 == threads ? rows : rows * (t + 1) / threads / BATCH_BLOCK * BATCH_BLOCK;
+        workers.emplace_back([&, t, begin, end] {
+            try {
+                vector<double> scratch;
+                evaluateRows(prog, columns, out, begin, end, scratch);
+            } catch (...) {
+                errors[t] = current_exception();
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    for (auto& e : errors)
+        if (e) rethrow_exception(e);
+}
+
+// Binds input columns by variable name
+void evaluateBatch(const Program& prog, const map<string, const vector<double>*>& columns,
+                   vector<double>& out, size_t threads = 0) {
+    vector<const double*> bound;
+    size_t rows = SIZE_MAX;
+    for (const auto& name : prog.variables()) {
+        auto it = columns.find(name);
+        if (it == columns.end()) throw runtime_error("Unbound variable: " + name);
+        bound.push_back(it->second->data());
+        rows = min(rows, it->second->size());
+    }
+    if (rows == SIZE_MAX) rows = out.size();
+    out.resize(rows);
+    evaluateBatch(prog, bound, out.data(), rows, threads);
+}
+
+// ------------ Expression cache ------------
+// Maps normalized expression text to its compiled (and optimized)
+// program, so a service that sees the same expressions over and over
+// parses each one once. Constant-only expressions also keep their value
+// (or their division-by-zero error) and are answered without running.
+//
+// The cache is split into shards by key hash. Each shard has a
+// shared_mutex: lookups take it shared, so concurrent readers never
+// block one another, and record recency in a per-entry atomic tick. The
+// tick source only advances on inserts and a hit writes its entry's tick
+// only when it changed, so hot entries are not written on every lookup.
+// Inserts take it exclusively and evict entries until the shard fits in
+// its share of the memory bound. Each shard keeps its entries in a list in
+// the order they were queued; eviction takes the front, but an entry used
+// since it was queued goes to the back once more instead (second chance).
+// That approximates LRU at amortized O(1) per eviction without making a
+// hit reorder the list.
+struct CachedExpression {
+    Program program;          // optimized
+    bool constant = false;    // no variables: value / error are memoized
+    double value = 0;
+    string error;             // non-empty when the constant expression throws
+};
+
+struct CacheStats {
+    uint64_t hits = 0, misses = 0, evictions = 0;
+    size_t entries = 0, bytes = 0;
+};
+
+// Drops whitespace wherever compile() would read the same tokens without
+// it, so "2+3" and " 2 + 3 " share one entry. A gap is kept when it ends a
+// token: between two number or name characters ("1 2" is an error, not
+// 12), and next to the sign of an exponent, since strtod() reads "2e-3"
+// as one number but "2e -3" and "2e- 3" as 2 followed by the name e.
+void normalizeExpression(const string& expr, string& key) {
+    auto isWordChar = [](char c) { return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.'; };
+    auto isExponent = [](char c) { return c == 'e' || c == 'E' || c == 'p' || c == 'P'; };
+    auto isSign = [](char c) { return c == '+' || c == '-'; };
+    key.resize(expr.size());
+    size_t n = 0;
+    bool gap = false;
+    for (char c : expr) {
+        if (c == ' ' || (c >= '\t' && c <= '\r')) {
+            gap = true;
+            continue;
+        }
+        if (gap && n > 0) {
+            const char prev = key[n - 1], before = n > 1 ? key[n - 2] : ' ';
+            const bool keep = isWordChar(prev) ? isWordChar(c) || (isSign(c) && isExponent(prev))
+                                               : isSign(prev) && isExponent(before) && (isWordChar(c) || isSign(c));
+            if (keep) key[n++] = ' ';
+        }
+        key[n++] = c;
+        gap = false;
+    }
+    key.resize(n);
+}
+
+string normalizeExpression(const string& expr) {
+    string key;
+    normalizeExpression(expr, key);
+    return key;
+}
+
+class ExpressionCache {
+public:
+    explicit ExpressionCache(size_t maxBytes = 16 << 20, bool memoizeConstants = true, size_t shardCount = 16)
+        : memoize(memoizeConstants), shards(max<size_t>(1, shardCount)) {
+        for (auto& s : shards) s.budget = maxBytes / shards.size();
+    }
+
+    // Compiled program for expr; compiles and inserts it on a miss.
+    // Compile errors are thrown and not cached.
+    shared_ptr<const CachedExpression> get(const string& expr) {
+        // Reused per thread so a hit does not allocate a key
+        thread_local string key;
+        normalizeExpression(expr, key);
+        Shard& shard = shards[hash<string>()(key) % shards.size()];
+        {
+            shared_lock<shared_mutex> lock(shard.mutex);
+            auto it = shard.map.find(key);
+            if (it != shard.map.end()) {
+                const uint64_t now = clock.load(memory_order_relaxed);
+                if (it->second.lastUse.load(memory_order_relaxed) != now)
+                    it->second.lastUse.store(now, memory_order_relaxed);
+                shard.hits.fetch_add(1, memory_order_relaxed);
+                return it->second.value;
+            }
+        }
+        shard.misses.fetch_add(1, memory_order_relaxed);
+
+        // Compile outside the lock so a miss never stalls the shard's readers
+        auto entry = make_shared<CachedExpression>();
+        entry->program = optimize(compile(key));
+        if (memoize && entry->program.variables().empty()) {
+            entry->constant = true;
+            try {
+                entry->value = entry->program.run();
+            } catch (const exception& e) {
+                entry->error = e.what();
+            }
+        }
+        const size_t bytes = footprint(key, *entry);
+
+        unique_lock<shared_mutex> lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it != shard.map.end()) return it->second.value;   // another thread won the race
+        if (bytes > shard.budget) return entry;               // too large to keep
+        while (shard.bytes + bytes > shard.budget) evictOldest(shard);
+        auto& node = *shard.map.try_emplace(key).first;
+        Slot& slot = node.second;
+        slot.value = entry;
+        slot.bytes = bytes;
+        slot.queuedAt = clock.fetch_add(1, memory_order_relaxed);
+        slot.lastUse.store(slot.queuedAt, memory_order_relaxed);
+        shard.lru.push_back(&node);
+        shard.bytes += bytes;
+        return entry;
+    }
+
+    // Value of an expression without variables
+    double evaluate(const string& expr) {
+        auto e = get(expr);
+        if (!e->program.variables().empty())
+            throw runtime_error("Unbound variable: " + e->program.variables().front());
+        return constantValue(*e);
+    }
+
+    double evaluate(const string& expr, const vector<double>& vars) {
+        auto e = get(expr);
+        if (e->program.variables().empty()) return constantValue(*e);
+        return e->program.run(vars);
+    }
+
+    CacheStats stats() const {
+        CacheStats total;
+        for (const auto& s : shards) {
+            total.hits += s.hits.load(memory_order_relaxed);
+            total.misses += s.misses.load(memory_order_relaxed);
+            total.evictions += s.evictions.load(memory_order_relaxed);
+            shared_lock<shared_mutex> lock(s.mutex);
+            total.entries += s.map.size();
+            total.bytes += s.bytes;
+        }
+        return total;
+    }
+
+    void clear() {
+        for (auto& s : shards) {
+            unique_lock<shared_mutex> lock(s.mutex);
+            s.map.clear();
+            s.lru.clear();
+            s.bytes = 0;
+        }
+    }
+
+private:
+    struct Slot {
+        shared_ptr<const CachedExpression> value;
+        size_t bytes = 0;
+        atomic<uint64_t> lastUse{0};
+        uint64_t queuedAt = 0;   // lastUse when the entry was (re)queued
+    };
+
+    // Own cache lines per shard, so counter updates do not bounce
+    struct alignas(64) Shard {
+        mutable shared_mutex mutex;
+        unordered_map<string, Slot> map;
+        list<pair<const string, Slot>*> lru;   // eviction order; nodes of 'map' are stable
+        size_t bytes = 0, budget = 0;
+        atomic<uint64_t> hits{0}, misses{0}, evictions{0};
+    };
+
+    bool memoize;
+    vector<Shard> shards;
+    atomic<uint64_t> clock{0};
+
+    static double constantValue(const CachedExpression& e) {
+        if (!e.constant) return e.program.run();
+        if (!e.error.empty()) throw runtime_error(e.error);
+        return e.value;
+    }
+
+    // Approximate heap bytes held for one entry
+    static size_t footprint(const string& key, const CachedExpression& e) {
+        size_t bytes = sizeof(Slot) + sizeof(CachedExpression) + 2 * key.capacity() + 64;
+        bytes += e.program.code().capacity() * sizeof(Instr) + e.error.capacity();
+        for (const auto& name : e.program.variables()) bytes += sizeof(string) + name.capacity();
+        return bytes;
+    }
+
+    // Caller holds the shard exclusively, so no hit can move a tick while
+    // this runs and every entry is requeued at most once
+    void evictOldest(Shard& shard) {
+        while (true) {
+            auto* node = shard.lru.front();
+            shard.lru.pop_front();
+            Slot& slot = node->second;
+            const uint64_t used = slot.lastUse.load(memory_order_relaxed);
+            if (used != slot.queuedAt) {
+                slot.queuedAt = used;
+                shard.lru.push_back(node);
+                continue;
+            }
+            shard.bytes -= slot.bytes;
+            shard.map.erase(shard.map.find(node->first));
+            shard.evictions.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+    }
+};
+
 // ------------ Test Cases ------------
 void runTests() {
     map<string, double> tests = {
@@ -102,8 +941,9 @@ void runTests() {
     for (const auto& [expr, expected] : tests) {
         try {
             double result = evaluate(expr);
+            double compiled = compile(expr).run();
             cout << expr << " = " << result;
-            if (abs(result - expected) < 1e-6)
+            if (abs(result - expected) < 1e-6 && abs(compiled - expected) < 1e-6)
                 cout << "  Passed";
             else
                 cout << "  Failed (Expected: " << expected << ")";
@@ -114,16 +954,451 @@ void runTests() {
     }
 }
 
+// Compiled programs with variables bound at run time
+void runVariableTests() {
+    struct Case { string expr; vector<double> values; double expected; };
+    vector<Case> cases = {
+        {"x * 2 + 1", {4}, 9},
+        {"(a + b) * (a - b)", {5, 3}, 16},
+        {"-x * 3", {2}, -6},
+        {"rate * (1 + rate) / (rate - 0.5)", {1}, 4},
+        {"x / (y - y)", {1, 2}, NAN},   // division by zero
+    };
+
+    cout << "\nRunning compiled variable tests:\n";
+    for (const auto& c : cases) {
+        try {
+            Program prog = compile(c.expr);
+            double result = prog.run(c.values);
+            cout << c.expr << "  [" << disassemble(prog) << "] = " << result;
+            if (abs(result - c.expected) < 1e-6)
+                cout << "  Passed";
+            else
+                cout << "  Failed (Expected: " << c.expected << ")";
+            cout << endl;
+        } catch (const exception& e) {
+            cout << c.expr << "  Error: " << e.what() << (isnan(c.expected) ? "  Passed" : "") << endl;
+        }
+    }
+}
+
+// optimize() must not change any result, including division-by-zero errors
+void runOptimizerTests() {
+    struct Case { string expr; string expectedForm; };
+    vector<Case> cases = {
+        {"x * 1 + (2 * 3)", "x + 6"},
+        {"(a + b) * (b + a) - (a + b)", "(a + b) * (a + b) - (a + b)"},
+        {"x / 4 + y / 3", "x * 0.25 + y / 3"},
+        {"-(-x) - (-y)", "x + y"},
+        {"(x - 0) * -1 + 7 * (1 + 1) / 2", "7 - x"},
+        {"x / (2 - 2)", "x / 0"},
+    };
+
+    cout << "\nRunning optimizer tests:\n";
+    const vector<double> values = {1.5, -2.25};
+    for (const auto& c : cases) {
+        Program prog = compile(c.expr);
+        Program opt = optimize(prog);
+        string form = optimizedForm(prog);
+        vector<double> vars(values.begin(), values.begin() + prog.variables().size());
+        string plain, optimized;
+        try { plain = to_string(prog.run(vars)); } catch (const exception& e) { plain = e.what(); }
+        try { optimized = to_string(opt.run(vars)); } catch (const exception& e) { optimized = e.what(); }
+        cout << c.expr << "  =>  " << form << "  [" << disassemble(opt) << "]";
+        if (form == c.expectedForm && plain == optimized)
+            cout << "  Passed";
+        else
+            cout << "  Failed (Expected: " << c.expectedForm << ", " << plain << " vs " << optimized << ")";
+        cout << endl;
+    }
+}
+
+// Batch results must match row-by-row run() exactly
+void runBatchTests() {
+    Program prog = compile("(a - b) / (a + b) * 2");
+    const size_t rows = 1000;   // not a multiple of the block size
+    vector<double> a(rows), b(rows), out;
+    for (size_t r = 0; r < rows; ++r) {
+        a[r] = double(r) * 0.5 + 1;
+        b[r] = double(r % 13);
+    }
+    evaluateBatch(prog, {{"a", &a}, {"b", &b}}, out);
+    bool same = out.size() == rows;
+    for (size_t r = 0; same && r < rows; ++r) same = out[r] == prog.run(vector<double>{a[r], b[r]});
+
+    cout << "\nRunning batch tests:\n";
+    cout << "Batch of " << rows << " rows matches run(): " << (same ? "Passed" : "Failed") << endl;
+
+    const size_t bigRows = 3 * BATCH_ROWS_PER_THREAD + 17;   // split across 3 threads
+    vector<double> bigA(bigRows, 3.0), bigB(bigRows), bigOut;
+    for (size_t r = 0; r < bigRows; ++r) bigB[r] = double(r % 7);
+    evaluateBatch(prog, {{"a", &bigA}, {"b", &bigB}}, bigOut, 3);
+    bool bigSame = bigOut.size() == bigRows;
+    for (size_t r = 0; bigSame && r < bigRows; ++r) bigSame = bigOut[r] == prog.run(vector<double>{bigA[r], bigB[r]});
+    cout << "Batch of " << bigRows << " rows on 3 threads matches run(): " << (bigSame ? "Passed" : "Failed") << endl;
+
+    try {
+        b[700] = -a[700];
+        evaluateBatch(prog, {{"a", &a}, {"b", &b}}, out);
+        cout << "Division by zero in a batch  Failed (no error)" << endl;
+    } catch (const exception& e) {
+        cout << "Division by zero in a batch  Error: " << e.what() << "  Passed" << endl;
+    }
+
+    try {
+        prog.run();
+        cout << "run() without variable values  Failed (no error)" << endl;
+    } catch (const exception& e) {
+        cout << "run() without variable values  Error: " << e.what() << "  Passed" << endl;
+    }
+}
+
+// Hits, misses, memoized constants and LRU eviction under a tight bound
+void runCacheTests() {
+    cout << "\nRunning cache tests:\n";
+    ExpressionCache cache(8 << 10, true, 1);   // one shard of 8 KB
+    bool ok = cache.evaluate("2 + 4 * 3") == 14 && cache.evaluate(" 2+4*3 ") == 14;
+    CacheStats s = cache.stats();
+    cout << "Whitespace variants share one entry (1 miss, 1 hit): "
+         << (ok && s.misses == 1 && s.hits == 1 ? "Passed" : "Failed") << endl;
+
+    ok = cache.evaluate("x * x + 1", {3}) == 10 && cache.evaluate("x*x+1", {4}) == 17;
+    cout << "Programs with variables are reused: " << (ok && cache.stats().hits == 2 ? "Passed" : "Failed") << endl;
+
+    bool threw = false;
+    try { cache.evaluate("1 / (2 - 2)"); } catch (const exception&) { threw = true; }
+    try { cache.evaluate("1 / (2 - 2)"); } catch (const exception& e) { threw = threw && string(e.what()) == "Division by zero"; }
+    cout << "Memoized division by zero still throws: " << (threw ? "Passed" : "Failed") << endl;
+
+    // Whitespace that ends a token is kept in the key
+    size_t rejected = 0;
+    for (const char* bad : {"1 2", "3 .5", "1 2 + 3", "a b", "2e -3", "2e- 3"}) {
+        for (int pass = 0; pass < 2; ++pass) {
+            try { cache.evaluate(bad, {1}); } catch (const exception&) { ++rejected; }
+        }
+    }
+    cout << "Separated tokens are not merged by the cache key: " << (rejected == 12 ? "Passed" : "Failed") << endl;
+    ok = cache.evaluate("2e-3") == 0.002 && normalizeExpression(" x + 1 ") == normalizeExpression("x+1");
+    cout << "Exponents and spacing variants still normalize: " << (ok ? "Passed" : "Failed") << endl;
+
+    // Left-deep chains stay left-deep through the optimizer, so they need
+    // two stack slots however long they are
+    string chain = "x";
+    for (int i = 1; i < 300; ++i) chain += " + 1";
+    Program chainProg = optimize(compile(chain));
+    ok = cache.evaluate(chain, {2}) == 301 && chainProg.stackDepth() == 2 &&
+         optimizedForm(compile(chain)).size() == chain.size();
+    cout << "300-term sum through the optimizer (depth " << chainProg.stackDepth() << "): "
+         << (ok ? "Passed" : "Failed") << endl;
+
+    // An entry used between inserts survives; the others are evicted
+    bool kept = true;
+    for (int i = 0; i < 200; ++i) {
+        cache.evaluate(to_string(i) + " + 1");
+        const uint64_t hitsBefore = cache.stats().hits;
+        cache.evaluate("7 * 6");
+        kept = kept && (i == 0 || cache.stats().hits == hitsBefore + 1);
+    }
+    s = cache.stats();
+    cout << "LRU eviction keeps the cache under its bound (" << s.entries << " entries, " << s.bytes
+         << " bytes, " << s.evictions << " evictions): "
+         << (s.bytes <= (8 << 10) && s.evictions > 0 ? "Passed" : "Failed") << endl;
+    cout << "Entry used between inserts is never evicted: " << (kept ? "Passed" : "Failed") << endl;
+}
+
+// ------------ Benchmarks ------------
+template<typename F>
+double secondsFor(F&& f) {
+    auto start = chrono::high_resolution_clock::now();
+    f();
+    auto end = chrono::high_resolution_clock::now();
+    return chrono::duration<double>(end - start).count();
+}
+
+// Compile-once / run-many against re-parsing with evaluate() every time,
+// over the runTests() corpus and a formula with variables
+void benchmarkCompiled() {
+    const vector<string> corpus = {
+        "2 + 4 * 3", "(3 + 4) * 1", "7 + 3 * (10 / (12 / (3 + 1) - 1))", "(1 + 2) * (3 + 4)",
+        "10 + (6 / 3)", "(5 + 3) * ((2 + 1) * 2)", "(7 - 2) * 3 + 1", "100 / (5 * (2 + 3))",
+        "3.5 + 4.5 * 3", "(2 + 3.0) * 2"};
+    const size_t runs = 200000;
+    double sink = 0;
+
+    double tEval = secondsFor([&] {
+        for (size_t r = 0; r < runs; ++r)
+            for (const auto& e : corpus) sink += evaluate(e);
+    });
+    vector<Program> programs;
+    double tCompile = secondsFor([&] {
+        for (const auto& e : corpus) programs.push_back(compile(e));
+    });
+    double tRun = secondsFor([&] {
+        for (size_t r = 0; r < runs; ++r)
+            for (const auto& p : programs) sink += p.run();
+    });
+    const double n = double(runs * corpus.size());
+    cout << "\nCorpus of " << corpus.size() << " expressions, " << runs << " rounds:\n"
+         << "  evaluate() per call : " << tEval / n * 1e9 << " ns\n"
+         << "  compile once        : " << tCompile / corpus.size() * 1e9 << " ns per expression\n"
+         << "  run() per call      : " << tRun / n * 1e9 << " ns  (" << tEval / tRun << "x faster)\n";
+
+    // A formula over changing inputs; evaluate() has no variables, so it
+    // pays for splicing the values into the text as well
+    const string formula = "(x + 1) * (y - 2) / (x * y + 3) - x / 7";
+    Program prog = compile(formula);
+    const size_t calls = 1000000;
+    double vars[2];
+    double tBound = secondsFor([&] {
+        for (size_t k = 0; k < calls; ++k) {
+            vars[0] = double(k % 97);
+            vars[1] = double(k % 89);
+            sink += prog.run(vars);
+        }
+    });
+    double tText = secondsFor([&] {
+        for (size_t k = 0; k < calls / 10; ++k) {
+            string x = to_string(k % 97), y = to_string(k % 89);
+            sink += evaluate("(" + x + " + 1) * (" + y + " - 2) / (" + x + " * " + y + " + 3) - " + x + " / 7");
+        }
+    });
+    cout << "\nFormula " << formula << ":\n"
+         << "  run() with bound variables : " << tBound / calls * 1e9 << " ns per row\n"
+         << "  evaluate() on spliced text : " << tText / (calls / 10) * 1e9 << " ns per row\n"
+         << "  (checksum " << sink << ")\n";
+}
+
+// Rows per second for a derived column: evaluate() per row (on a sample,
+// since it re-parses spliced text), Program::run() per row, and the
+// block-wise batch mode on one thread and on all threads
+void benchmarkBatch() {
+    const string formula = "(x + 1) * (y - 2) / (x * y + 3) - x / 7";
+    Program prog = compile(formula);
+    const size_t rows = 1 << 22;
+    vector<double> x(rows), y(rows), out(rows), reference(rows);
+    for (size_t r = 0; r < rows; ++r) {
+        x[r] = double(r % 97) + 0.5;
+        y[r] = double(r % 89) + 0.25;
+    }
+    const size_t sample = 100000;
+    double sink = 0;
+    double tEval = secondsFor([&] {
+        for (size_t r = 0; r < sample; ++r) {
+            string xs = to_string(x[r]), ys = to_string(y[r]);
+            sink += evaluate("(" + xs + " + 1) * (" + ys + " - 2) / (" + xs + " * " + ys + " + 3) - " + xs + " / 7");
+        }
+    });
+    const size_t sx = prog.slotOf("x"), sy = prog.slotOf("y");
+    double tRun = secondsFor([&] {
+        double vars[2];
+        for (size_t r = 0; r < rows; ++r) {
+            vars[sx] = x[r];
+            vars[sy] = y[r];
+            reference[r] = prog.run(vars);
+        }
+    });
+    double tBatch1 = secondsFor([&] { evaluateBatch(prog, {{"x", &x}, {"y", &y}}, out, 1); });
+    double tBatchN = secondsFor([&] { evaluateBatch(prog, {{"x", &x}, {"y", &y}}, out); });
+
+    double err = 0;
+    for (size_t r = 0; r < rows; ++r) err = max(err, fabs(out[r] - reference[r]));
+    const unsigned hw = max(1u, thread::hardware_concurrency());
+    cout << "\nDerived column " << formula << " over " << rows << " rows:\n"
+         << "  evaluate() per row      : " << sample / tEval / 1e6 << " M rows/s\n"
+         << "  run() per row           : " << rows / tRun / 1e6 << " M rows/s\n"
+         << "  batch, 1 thread         : " << rows / tBatch1 / 1e6 << " M rows/s\n"
+         << "  batch, " << hw << " thread(s)      : " << rows / tBatchN / 1e6 << " M rows/s\n"
+         << "  max |batch - run()|     : " << err << "  (checksum " << sink << ")\n";
+}
+
+// Random expression over x, y, z with depth levels of binary operators.
+// Constants come from a small pool that includes identity elements, and
+// earlier subtrees are reused, so the optimizer has something to find.
+string generateExpression(int depth, mt19937& rng, vector<string>& pool) {
+    uniform_int_distribution<int> pick(0, 9);
+    static const char* leaves[] = {"x", "y", "z", "1", "2", "4", "0.5", "3", "1", "0"};
+    static const char ops[] = {'+', '-', '*', '/'};
+    if (depth == 0) return leaves[pick(rng)];
+    if (!pool.empty() && pick(rng) < 3) return pool[rng() % pool.size()];
+    int op = pick(rng) % 4;
+    string l = generateExpression(depth - 1, rng, pool);
+    string r = generateExpression(depth - 1, rng, pool);
+    if (op == 3 && r == "0") r = "3";   // keep the corpus free of constant division by zero
+    string e = "(" + l + " " + ops[op] + " " + r + ")";
+    pool.push_back(e);
+    return e;
+}
+
+// Instruction counts and run() / batch time before and after optimize(),
+// for the runTests() corpus and for larger generated expressions
+void benchmarkOptimizer() {
+    const vector<string> corpus = {
+        "2 + 4 * 3", "(3 + 4) * 1", "7 + 3 * (10 / (12 / (3 + 1) - 1))", "(1 + 2) * (3 + 4)",
+        "10 + (6 / 3)", "(5 + 3) * ((2 + 1) * 2)", "(7 - 2) * 3 + 1", "100 / (5 * (2 + 3))",
+        "3.5 + 4.5 * 3", "(2 + 3.0) * 2"};
+    const size_t runs = 200000;
+    double sink = 0;
+    size_t before = 0, after = 0;
+    vector<Program> plain, opt;
+    for (const auto& e : corpus) {
+        plain.push_back(compile(e));
+        opt.push_back(optimize(plain.back()));
+        before += plain.back().code().size();
+        after += opt.back().code().size();
+    }
+    double tPlain = secondsFor([&] {
+        for (size_t r = 0; r < runs; ++r)
+            for (const auto& p : plain) sink += p.run();
+    });
+    double tOpt = secondsFor([&] {
+        for (size_t r = 0; r < runs; ++r)
+            for (const auto& p : opt) sink += p.run();
+    });
+    const double n = double(runs * corpus.size());
+    cout << "\nOptimizer on the runTests() corpus: " << before << " -> " << after << " instructions\n"
+         << "  run() plain     : " << tPlain / n * 1e9 << " ns per expression\n"
+         << "  run() optimized : " << tOpt / n * 1e9 << " ns per expression\n";
+
+    mt19937 rng(2024);
+    const size_t rows = 1 << 16;
+    vector<double> x(rows), y(rows), z(rows), out(rows);
+    for (size_t r = 0; r < rows; ++r) {
+        x[r] = 1.0 + double(r % 31);
+        y[r] = 2.0 + double(r % 17);
+        z[r] = 0.5 + double(r % 13);
+    }
+    cout << "\nGenerated expressions (" << rows << " rows per batch):\n"
+         << "  depth | instructions plain -> opt | run() ns plain  opt | batch ms plain  opt\n";
+    cout << fixed << setprecision(1);
+    for (int depth : {4, 6, 8, 10}) {
+        map<string, const vector<double>*> cols = {{"x", &x}, {"y", &y}, {"z", &z}};
+        // Regenerate until the expression never divides by zero on the inputs
+        Program p, o;
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            vector<string> pool;
+            p = compile(generateExpression(depth, rng, pool));
+            try {
+                evaluateBatch(p, cols, out, 1);
+                break;
+            } catch (const exception&) {
+                p = Program();
+            }
+        }
+        if (p.code().empty()) continue;
+        o = optimize(p);
+        vector<double> vars(p.variables().size());
+        for (size_t i = 0; i < vars.size(); ++i) vars[i] = *cols[p.variables()[i]]->data();
+
+        const size_t calls = 200000;
+        double tp = secondsFor([&] { for (size_t k = 0; k < calls; ++k) sink += p.run(vars); });
+        double to = secondsFor([&] { for (size_t k = 0; k < calls; ++k) sink += o.run(vars); });
+        double bp = secondsFor([&] { evaluateBatch(p, cols, out, 1); });
+        double bo = secondsFor([&] { evaluateBatch(o, cols, out, 1); });
+        cout << "  " << setw(5) << depth << " | " << setw(18) << p.code().size() << " -> " << setw(4)
+             << o.code().size() << " | " << setw(14) << tp / calls * 1e9 << " " << setw(6) << to / calls * 1e9
+             << " | " << setw(14) << bp * 1e3 << " " << setw(4) << bo * 1e3 << "\n";
+    }
+    cout << "  (checksum " << sink << ")\n";
+}
+
+// Service-style load: threads evaluate expressions drawn with a skew from
+// a working set of a few thousand strings. Compares compiling every call
+// with the sharded cache, and the sharded cache with a single shard (all
+// inserts and evictions behind one lock).
+void benchmarkCache() {
+    const size_t distinct = 4000, callsPerThread = 200000;
+    vector<string> working;
+    mt19937 gen(99);
+    const vector<double> vars = {1.5};
+    while (working.size() < distinct) {
+        // A quarter use a variable; the rest are constant. Anything that
+        // divides by zero is regenerated so the loop measures lookups, not throws.
+        vector<string> pool;
+        size_t i = working.size();
+        string e = generateExpression(3, gen, pool) + (i % 4 == 0 ? " + x" : " + " + to_string(i));
+        try {
+            Program p = compile(e);
+            p.variables().empty() ? p.run() : p.run(vars);
+            working.push_back(e);
+        } catch (const exception&) {
+        }
+    }
+
+    double checksum = 0;
+    auto run = [&](size_t threads, auto&& evaluateOne) {
+        vector<thread> workers;
+        vector<double> sinks(threads, 0.0);
+        double t = secondsFor([&] {
+            for (size_t w = 0; w < threads; ++w) {
+                workers.emplace_back([&, w] {
+                    mt19937 rng(unsigned(w + 1));
+                    // Squaring a uniform draw skews lookups toward the front of the set
+                    uniform_real_distribution<double> u(0.0, 1.0);
+                    double sink = 0;
+                    for (size_t k = 0; k < callsPerThread; ++k) {
+                        double r = u(rng);
+                        sink += evaluateOne(working[size_t(r * r * distinct)]);
+                    }
+                    sinks[w] = sink;
+                });
+            }
+            for (auto& w : workers) w.join();
+        });
+        for (double v : sinks) checksum += v;
+        return double(threads * callsPerThread) / t;
+    };
+
+    cout << "\nExpression cache, " << distinct << " distinct expressions, skewed lookups (M calls/s):\n"
+         << "  threads | compile every call | cache, 16 shards | cache, 1 shard\n";
+    const unsigned hw = max(1u, thread::hardware_concurrency());
+    for (size_t threads : {size_t(1), size_t(2), size_t(4), size_t(hw)}) {
+        double tCompile = run(threads, [&](const string& e) {
+            Program p = compile(e);
+            return p.variables().empty() ? p.run() : p.run(vars);
+        });
+        // Caches are warmed first: a long-running service sees steady-state hits
+        ExpressionCache sharded(4 << 20), single(4 << 20, true, 1);
+        for (const auto& e : working) {
+            sharded.evaluate(e, vars);
+            single.evaluate(e, vars);
+        }
+        double tSharded = run(threads, [&](const string& e) { return sharded.evaluate(e, vars); });
+        double tSingle = run(threads, [&](const string& e) { return single.evaluate(e, vars); });
+        CacheStats s = sharded.stats();
+        cout << "  " << setw(7) << threads << " | " << setw(18) << tCompile / 1e6 << " | " << setw(16)
+             << tSharded / 1e6 << " | " << setw(14) << tSingle / 1e6 << "   (hit rate "
+             << 100.0 * s.hits / max<uint64_t>(1, s.hits + s.misses) << "%, " << s.entries << " entries, "
+             << s.bytes / 1024 << " KB)\n";
+        if (threads == hw) break;
+    }
+    cout << "  (checksum " << checksum << ")\n";
+}
+
 // ------------ Main ------------
-int main() {
+// Run with --bench for the compile-once / run-many benchmark
+int main(int argc, char** argv) {
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        benchmarkCompiled();
+        benchmarkBatch();
+        benchmarkOptimizer();
+        benchmarkCache();
+        return 0;
+    }
+
     runTests();
+    runVariableTests();
+    runBatchTests();
+    runOptimizerTests();
+    runCacheTests();
 
+    // Repeated lines are served from the cache instead of being re-parsed
+    ExpressionCache cache;
     cout << "\nEnter your own expression (or type 'exit'): ";
     string input;
     while (getline(cin, input)) {
         if (input == "exit") break;
         try {
-            double result = evaluate(input);
+            double result = cache.evaluate(input);
             cout << "Result = " << result << endl;
         } catch (const exception& e) {
             cout << "Error: " << e.what() << endl;
@@ -8,6 +8,32 @@
 #include <vector>
 #include <memory>
 #include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <string>
+#include <iomanip>
+#include <stdexcept>
+#include <initializer_list>
+#include <type_traits>
+#include <new>
+#include <cstdlib>
+#include <cstddef>
+#include <numeric>
+#include <set>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <optional>
+#include <utility>
+
+#include "AllocationCounter.h"
+
+// Coroutine support needs C++20 (g++ -std=c++20); C++17 builds skip it
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#include <coroutine>
+#define THREADPOOL_COROUTINES 1
+#endif
 
 // Struct to represent a task with priority
 struct TaskItem {
@@ -35,13 +61,17 @@ public:
                         if (stop && taskQueue.empty())
                             return;
 
-                        task = taskQueue.top();
+                        // top() is const only to protect the heap order, which
+                        // pop() discards anyway; moving avoids copying the function
+                        task = std::move(const_cast<TaskItem&>(taskQueue.top()));
                         taskQueue.pop();
                     }
                     try {
                         task.func(); // May throw, will be captured by packaged_task
+                    } catch (const std::exception& ex) {
+                        std::cerr << "[ThreadPool] Unhandled exception in task: " << ex.what() << "\n";
                     } catch (...) {
-                        std::cerr << "[ThreadPool] Unhandled exception in task.\n";
+                        std::cerr << "[ThreadPool] Unhandled non-standard exception in task.\n";
                     }
                 }
             });
@@ -79,6 +109,16 @@ public:
         return fut;
     }
 
+    // Fire-and-forget: no future, exceptions are only reported
+    template <class Func>
+    void post(Func&& f, int priority = 0) {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            taskQueue.emplace(TaskItem{priority, std::forward<Func>(f)});
+        }
+        condition.notify_one();
+    }
+
 private:
     std::vector<std::thread> workers;
     std::priority_queue<TaskItem> taskQueue;
@@ -87,9 +127,1256 @@ private:
     bool stop;
 };
 
+// === Allocation-free task nodes ===
+// A void() callable kept inside the object when it fits in INLINE_SIZE bytes
+// (a lambda capturing a few pointers, a packaged_task); larger ones fall back
+// to the heap. Constructed in place and never moved, so no move support.
+class InlineCallable {
+public:
+    static constexpr size_t INLINE_SIZE = 48;
+
+    InlineCallable() = default;
+    InlineCallable(const InlineCallable&) = delete;
+    InlineCallable& operator=(const InlineCallable&) = delete;
+    ~InlineCallable() { reset(); }
+
+    template <class F>
+    void emplace(F&& f) {
+        using D = std::decay_t<F>;
+        reset();
+        if constexpr (sizeof(D) <= INLINE_SIZE && alignof(D) <= alignof(std::max_align_t)) {
+            new (storage) D(std::forward<F>(f));
+            invokeFn = [](void* p) { (*static_cast<D*>(p))(); };
+            destroyFn = [](void* p) { static_cast<D*>(p)->~D(); };
+        } else {
+            *reinterpret_cast<D**>(storage) = new D(std::forward<F>(f));
+            invokeFn = [](void* p) { (**static_cast<D**>(p))(); };
+            destroyFn = [](void* p) { delete *static_cast<D**>(p); };
+        }
+    }
+
+    void operator()() { invokeFn(storage); }
+
+    void reset() {
+        if (destroyFn) destroyFn(storage);
+        invokeFn = nullptr;
+        destroyFn = nullptr;
+    }
+
+private:
+    alignas(std::max_align_t) unsigned char storage[INLINE_SIZE];
+    void (*invokeFn)(void*) = nullptr;
+    void (*destroyFn)(void*) = nullptr;
+};
+
+// One queued task; prev/next link it into a worker's band list
+struct TaskNode {
+    InlineCallable func;
+    int priority = 0;
+    uint64_t enqueuedAt = 0;   // only set while stats are enabled
+    TaskNode* prev = nullptr;
+    TaskNode* next = nullptr;
+};
+
+// Recycles TaskNodes. Every thread keeps a private free list; surplus nodes
+// move in batches to a shared depot, so nodes freed by workers flow back to
+// the threads that submit. Nodes come from slabs that live until exit.
+class TaskNodePool {
+public:
+    static TaskNode* acquire() {
+        LocalCache& cache = localCache();
+        if (!cache.head) refill(cache);
+        TaskNode* node = cache.head;
+        cache.head = node->next;
+        --cache.count;
+        node->next = nullptr;
+        return node;
+    }
+
+    // The node's callable must already be reset
+    static void release(TaskNode* node) {
+        LocalCache& cache = localCache();
+        node->next = cache.head;
+        cache.head = node;
+        if (++cache.count >= 2 * BATCH) spill(cache, BATCH);
+    }
+
+private:
+    static constexpr size_t BATCH = 128, SLAB = 256;
+
+    struct Batch { TaskNode* head; size_t count; };
+
+    struct Depot {
+        std::mutex mutex;
+        std::vector<Batch> batches;
+        std::vector<std::unique_ptr<TaskNode[]>> slabs;
+    };
+
+    struct LocalCache {
+        TaskNode* head = nullptr;
+        size_t count = 0;
+        ~LocalCache() { if (count) spill(*this, count); }
+    };
+
+    static Depot& depot() {
+        static Depot d;
+        return d;
+    }
+
+    static LocalCache& localCache() {
+        static thread_local LocalCache cache;
+        return cache;
+    }
+
+    static void refill(LocalCache& cache) {
+        Depot& d = depot();
+        std::lock_guard<std::mutex> lock(d.mutex);
+        if (!d.batches.empty()) {
+            cache.head = d.batches.back().head;
+            cache.count = d.batches.back().count;
+            d.batches.pop_back();
+            return;
+        }
+        d.slabs.emplace_back(new TaskNode[SLAB]);
+        TaskNode* slab = d.slabs.back().get();
+        for (size_t i = 0; i + 1 < SLAB; ++i) slab[i].next = &slab[i + 1];
+        cache.head = slab;
+        cache.count = SLAB;
+    }
+
+    static void spill(LocalCache& cache, size_t n) {
+        TaskNode* head = cache.head;
+        TaskNode* last = head;
+        for (size_t i = 1; i < n; ++i) last = last->next;
+        cache.head = last->next;
+        cache.count -= n;
+        last->next = nullptr;
+        Depot& d = depot();
+        std::lock_guard<std::mutex> lock(d.mutex);
+        d.batches.push_back(Batch{head, n});
+    }
+};
+
+// === Scheduler instrumentation ===
+// WorkStealingPool keeps per-worker counters and log2 histograms that only
+// their own worker writes (a relaxed load and store, no locked instruction),
+// so snapshot() can read them at any time without stopping the pool. They
+// are updated only while enableStats(true) is in effect; otherwise each task
+// pays for one relaxed flag load. Queue depth is always known.
+constexpr int HISTOGRAM_BUCKETS = 40;   // bucket b: [2^(b-1), 2^b) ns, bucket 0: 0 ns
+
+inline uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline int histogramBucket(uint64_t ns) {
+    int b = 0;
+    while (ns && b < HISTOGRAM_BUCKETS - 1) { ns >>= 1; ++b; }
+    return b;
+}
+
+struct Histogram {
+    uint64_t counts[HISTOGRAM_BUCKETS] = {};
+
+    uint64_t total() const {
+        uint64_t n = 0;
+        for (uint64_t c : counts) n += c;
+        return n;
+    }
+
+    // Upper bound in ns of the bucket holding quantile q (0..1); 0 if empty
+    uint64_t percentile(double q) const {
+        const uint64_t n = total();
+        if (n == 0) return 0;
+        uint64_t seen = 0;
+        for (int b = 0; b < HISTOGRAM_BUCKETS; ++b) {
+            seen += counts[b];
+            if (seen >= q * n) return b == 0 ? 0 : uint64_t(1) << b;
+        }
+        return uint64_t(1) << (HISTOGRAM_BUCKETS - 1);
+    }
+
+    Histogram& operator+=(const Histogram& o) {
+        for (int b = 0; b < HISTOGRAM_BUCKETS; ++b) counts[b] += o.counts[b];
+        return *this;
+    }
+};
+
+struct WorkerStats {
+    uint64_t tasks = 0;        // tasks run
+    uint64_t stolen = 0;       // of which taken from another worker's deque
+    uint64_t parks = 0;        // times the worker went to sleep
+    uint64_t inversions = 0;   // tasks started while a higher band was queued
+    uint64_t busyNs = 0, idleNs = 0;
+    size_t queueDepth = 0, maxQueueDepth = 0;
+    Histogram waitNs;          // time from push to start
+    Histogram runNs;           // task body duration
+};
+
+struct PoolStats {
+    std::vector<WorkerStats> workers;
+    uint64_t externalTasks = 0;   // run by non-worker threads helping in a parallel loop
+    uint64_t exceptions = 0;      // escaped from post()ed tasks
+
+    WorkerStats total() const {
+        WorkerStats t;
+        for (const WorkerStats& w : workers) {
+            t.tasks += w.tasks;
+            t.stolen += w.stolen;
+            t.parks += w.parks;
+            t.inversions += w.inversions;
+            t.busyNs += w.busyNs;
+            t.idleNs += w.idleNs;
+            t.queueDepth += w.queueDepth;
+            t.maxQueueDepth = std::max(t.maxQueueDepth, w.maxQueueDepth);
+            t.waitNs += w.waitNs;
+            t.runNs += w.runNs;
+        }
+        return t;
+    }
+
+    void print(std::ostream& os) const {
+        auto row = [&os](const std::string& name, const WorkerStats& w) {
+            os << std::setw(7) << name << " | " << std::setw(8) << w.tasks << " " << std::setw(7) << w.stolen
+               << " " << std::setw(6) << w.parks << " " << std::setw(6) << w.inversions << " | "
+               << std::setw(8) << w.busyNs / 1000000.0 << " " << std::setw(8) << w.idleNs / 1000000.0 << " | "
+               << std::setw(5) << w.queueDepth << " " << std::setw(5) << w.maxQueueDepth << " | "
+               << std::setw(8) << w.waitNs.percentile(0.5) << " " << std::setw(9) << w.waitNs.percentile(0.99)
+               << " | " << std::setw(8) << w.runNs.percentile(0.5) << " " << std::setw(9)
+               << w.runNs.percentile(0.99) << "\n";
+        };
+        std::ios::fmtflags flags = os.flags();
+        os << std::fixed << std::setprecision(2)
+           << " worker |    tasks  stolen  parks  inver |  busy ms  idle ms | depth   max |"
+           << " wait p50  wait p99 |  run p50   run p99 (ns)\n";
+        for (size_t w = 0; w < workers.size(); ++w) row(std::to_string(w), workers[w]);
+        row("total", total());
+        os << "external tasks: " << externalTasks << ", exceptions: " << exceptions << "\n";
+        os.flags(flags);
+    }
+};
+
+// === Work-stealing scheduler ===
+// Each worker owns one deque per priority band instead of sharing one locked
+// heap. A worker pops its own newest task (LIFO, cache-warm) from its highest
+// non-empty band; an idle worker steals the oldest task of the highest band
+// from a random victim. Priority order is approximate: higher bands run first,
+// order inside a band is not guaranteed.
+class WorkStealingPool {
+public:
+    static constexpr int PRIORITY_BANDS = 4;
+
+    // Coarse mapping from priority to band: <= 0, 1..3, 4..7, >= 8
+    static int bandOf(int priority) {
+        return priority <= 0 ? 0 : priority < 4 ? 1 : priority < 8 ? 2 : 3;
+    }
+
+    explicit WorkStealingPool(size_t threads)
+        : queues(std::max<size_t>(1, threads)), live(queues.size()), traces(queues.size()) {
+        for (size_t i = 0; i < queues.size(); ++i)
+            workers.emplace_back([this, i] { workerLoop(i); });
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(parkMutex);
+            stop = true;
+        }
+        parkCv.notify_all();
+        for (std::thread& t : workers)
+            t.join();
+    }
+
+    size_t size() const { return queues.size(); }
+
+    // Same contract as ThreadPool::submit. The packaged_task sits inside the
+    // pooled node, so the future's shared state is the only allocation.
+    template <class Func>
+    std::future<void> submit(Func&& f, int priority = 0, std::shared_future<void> dependency = {}) {
+        std::packaged_task<void()> task(std::forward<Func>(f));
+        std::future<void> fut = task.get_future();
+        push(makeNode([task = std::move(task), dep = std::move(dependency)]() mutable {
+            if (dep.valid()) dep.get();  // Wait for dependency
+            task();                      // Run task (will capture exceptions)
+        }, priority));
+        return fut;
+    }
+
+    // Runs one queued task on the calling thread, if there is one, so a
+    // thread waiting for a parallel loop helps instead of blocking. Workers
+    // look at their own deque first; other threads only steal.
+    bool runPendingTask() {
+        TaskNode* task = nullptr;
+        bool stolen = true;
+        if (currentPool == this) {
+            unsigned pops = 0;
+            if (!findTask(currentIndex, task, false, pops, stolen)) return false;
+            execute(currentIndex, task, stolen);
+            return true;
+        }
+        const size_t n = queues.size(), start = nextRandom() % n;
+        size_t k = 0;
+        while (k < n && !take(queues[(start + k) % n], false, 0, false, task)) ++k;
+        if (k == n) return false;
+        execute(EXTERNAL, task, true);
+        return true;
+    }
+
+    // Fire-and-forget: no future, exceptions are only reported. Callables up
+    // to InlineCallable::INLINE_SIZE bytes are queued without any allocation.
+    template <class Func>
+    void post(Func&& f, int priority = 0) {
+        push(makeNode(std::forward<Func>(f), priority));
+    }
+
+    // Called with every exception that escapes a post()ed task (submit()
+    // keeps its exceptions in the future). Set it before queueing tasks;
+    // without one the exception is printed to std::cerr.
+    void setExceptionHandler(std::function<void(std::exception_ptr)> handler) {
+        exceptionHandler = std::move(handler);
+    }
+
+    // Timing counters and histograms; off by default
+    void enableStats(bool on) {
+        if (on) instrumentation.fetch_or(STATS, std::memory_order_relaxed);
+        else instrumentation.fetch_and(~STATS, std::memory_order_relaxed);
+    }
+
+    // Consistent per counter, not across counters: safe while tasks run
+    PoolStats snapshot() const {
+        PoolStats out;
+        out.workers.resize(queues.size());
+        for (size_t w = 0; w < queues.size(); ++w) {
+            const LiveStats& l = live[w];
+            WorkerStats& s = out.workers[w];
+            s.tasks = l.tasks.load(std::memory_order_relaxed);
+            s.stolen = l.stolen.load(std::memory_order_relaxed);
+            s.parks = l.parks.load(std::memory_order_relaxed);
+            s.inversions = l.inversions.load(std::memory_order_relaxed);
+            s.busyNs = l.busyNs.load(std::memory_order_relaxed);
+            s.idleNs = l.idleNs.load(std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> lock(queues[w].mutex);
+                s.queueDepth = queues[w].depth;
+                s.maxQueueDepth = queues[w].maxDepth;
+            }
+            for (int b = 0; b < HISTOGRAM_BUCKETS; ++b) {
+                s.waitNs.counts[b] = l.waitNs[b].load(std::memory_order_relaxed);
+                s.runNs.counts[b] = l.runNs[b].load(std::memory_order_relaxed);
+            }
+        }
+        out.externalTasks = externalTasks.load(std::memory_order_relaxed);
+        out.exceptions = exceptionCount.load(std::memory_order_relaxed);
+        return out;
+    }
+
+    // Records up to 'eventsPerWorker' task and park spans per worker until
+    // stopTrace(). Each worker (re)initializes its own buffer on its next
+    // event, so the trace costs nothing while it is off.
+    void startTrace(size_t eventsPerWorker = 1 << 16) {
+        traceCapacity.store(eventsPerWorker, std::memory_order_relaxed);
+        traceEpoch.store(nowNs(), std::memory_order_relaxed);
+        traceGeneration.fetch_add(1, std::memory_order_release);
+        instrumentation.fetch_or(TRACE, std::memory_order_release);
+    }
+
+    void stopTrace() { instrumentation.fetch_and(~TRACE, std::memory_order_release); }
+
+    // Chrome trace JSON (chrome://tracing, Perfetto). Call after stopTrace()
+    // once the traced work has finished.
+    void writeChromeTrace(std::ostream& os) const {
+        const unsigned generation = traceGeneration.load(std::memory_order_acquire);
+        const double epoch = double(traceEpoch.load(std::memory_order_relaxed));
+        os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        auto comma = [&] { if (!first) os << ",\n"; first = false; };
+        char ts[64];
+        for (size_t w = 0; w < traces.size(); ++w) {
+            comma();
+            os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << w
+               << ",\"args\":{\"name\":\"worker " << w << "\"}}";
+            const TraceBuffer& t = traces[w];
+            if (t.generation.load(std::memory_order_acquire) != generation) continue;
+            const size_t n = t.count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < n; ++i) {
+                const TraceEvent& e = t.events[i];
+                comma();
+                std::snprintf(ts, sizeof ts, "\"ts\":%.3f,\"dur\":%.3f", (e.startNs - epoch) * 1e-3, e.durNs * 1e-3);
+                os << "{\"name\":\"" << (e.park ? "park" : "task") << "\",\"cat\":\"pool\",\"ph\":\"X\","
+                   << ts << ",\"pid\":1,\"tid\":" << w;
+                if (!e.park)
+                    os << ",\"args\":{\"priority\":" << e.priority << ",\"stolen\":"
+                       << (e.stolen ? "true" : "false") << "}";
+                os << "}";
+            }
+            if (size_t dropped = t.dropped.load(std::memory_order_relaxed)) {
+                comma();
+                os << "{\"name\":\"dropped " << dropped << " events\",\"ph\":\"i\",\"s\":\"t\",\"ts\":0,"
+                   << "\"pid\":1,\"tid\":" << w << "}";
+            }
+        }
+        os << "]}\n";
+    }
+
+private:
+    static constexpr unsigned SPIN_ROUNDS = 64;     // failed scans before parking
+    static constexpr unsigned PRIORITY_POLL = 8;    // local pops between checks for higher bands
+    static constexpr size_t EXTERNAL = SIZE_MAX;    // task run by a helping non-worker thread
+
+    // Intrusive list per band: owners push and pop at the tail, thieves take
+    // from the head
+    struct Band {
+        TaskNode* head = nullptr;
+        TaskNode* tail = nullptr;
+    };
+
+    struct alignas(64) WorkerQueue {
+        mutable std::mutex mutex;
+        Band bands[PRIORITY_BANDS];
+        std::atomic<unsigned> mask{0};   // bit b set while bands[b] is non-empty
+        size_t depth = 0, maxDepth = 0;   // maxDepth is tracked while stats are on
+    };
+
+    // Written only by the owning worker, read by snapshot()
+    struct alignas(64) LiveStats {
+        std::atomic<uint64_t> tasks{0}, stolen{0}, parks{0}, inversions{0}, busyNs{0}, idleNs{0};
+        std::atomic<uint64_t> waitNs[HISTOGRAM_BUCKETS] = {}, runNs[HISTOGRAM_BUCKETS] = {};
+    };
+
+    struct TraceEvent {
+        uint64_t startNs, durNs;
+        int priority;
+        bool stolen, park;
+    };
+
+    // Filled only by the owning worker; count is published with release
+    struct alignas(64) TraceBuffer {
+        std::unique_ptr<TraceEvent[]> events;
+        size_t capacity = 0;
+        std::atomic<size_t> count{0}, dropped{0};
+        std::atomic<unsigned> generation{0};
+    };
+
+    // Tasks submitted by a worker of this pool stay on that worker's deque
+    static inline thread_local WorkStealingPool* currentPool = nullptr;
+    static inline thread_local size_t currentIndex = 0;
+
+    static unsigned nextRandom() {
+        static thread_local unsigned state =
+            static_cast<unsigned>(std::hash<std::thread::id>()(std::this_thread::get_id())) | 1u;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // Single-writer increment: a plain load and store, no locked instruction
+    static void bump(std::atomic<uint64_t>& c, uint64_t by = 1) {
+        c.store(c.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+
+    template <class Func>
+    static TaskNode* makeNode(Func&& f, int priority) {
+        TaskNode* node = TaskNodePool::acquire();
+        try {
+            node->func.emplace(std::forward<Func>(f));
+        } catch (...) {
+            TaskNodePool::release(node);
+            throw;
+        }
+        node->priority = priority;
+        return node;
+    }
+
+    static int highestBand(unsigned mask) {
+        int b = -1;
+        while (mask) { ++b; mask >>= 1; }
+        return b;
+    }
+
+    void push(TaskNode* node) {
+        const size_t target = currentPool == this ? currentIndex : nextRandom() % queues.size();
+        const int band = bandOf(node->priority);
+        const bool stats = instrumentation.load(std::memory_order_relaxed) & STATS;
+        node->enqueuedAt = stats ? nowNs() : 0;
+        WorkerQueue& q = queues[target];
+        {
+            std::lock_guard<std::mutex> lock(q.mutex);
+            Band& d = q.bands[band];
+            node->prev = d.tail;
+            node->next = nullptr;
+            if (d.tail) d.tail->next = node;
+            else d.head = node;
+            d.tail = node;
+            q.mask.store(q.mask.load(std::memory_order_relaxed) | (1u << band),
+                         std::memory_order_relaxed);
+            if (++q.depth > q.maxDepth && stats) q.maxDepth = q.depth;
+        }
+        // A parking worker increments sleepers before its final locked scan,
+        // so either that scan sees this task or we see the sleeper here
+        if (sleepers.load() > 0) {
+            std::lock_guard<std::mutex> lock(parkMutex);
+            parkCv.notify_one();
+        }
+    }
+
+    // Takes the newest (owner) or oldest (thief) task of the highest band
+    // >= minBand. With precise = false an empty-looking mask skips the lock.
+    static bool take(WorkerQueue& q, bool newest, int minBand, bool precise, TaskNode*& out) {
+        if (!precise && (q.mask.load(std::memory_order_relaxed) >> minBand) == 0)
+            return false;
+        std::lock_guard<std::mutex> lock(q.mutex);
+        for (int b = PRIORITY_BANDS - 1; b >= minBand; --b) {
+            Band& d = q.bands[b];
+            if (!d.head) continue;
+            if (newest) {
+                out = d.tail;
+                d.tail = out->prev;
+                if (d.tail) d.tail->next = nullptr;
+                else d.head = nullptr;
+            } else {
+                out = d.head;
+                d.head = out->next;
+                if (d.head) d.head->prev = nullptr;
+                else d.tail = nullptr;
+            }
+            if (!d.head)
+                q.mask.store(q.mask.load(std::memory_order_relaxed) & ~(1u << b),
+                             std::memory_order_relaxed);
+            --q.depth;
+            return true;
+        }
+        return false;
+    }
+
+    bool findTask(size_t self, TaskNode*& out, bool precise, unsigned& pops, bool& stolen) {
+        const size_t n = queues.size();
+        const size_t start = nextRandom() % n;
+        WorkerQueue& own = queues[self];
+        stolen = true;
+
+        // Every few pops, prefer a higher band waiting on another worker
+        const int best = highestBand(own.mask.load(std::memory_order_relaxed));
+        if (!precise && best >= 0 && best < PRIORITY_BANDS - 1 && ++pops % PRIORITY_POLL == 0) {
+            for (size_t k = 0; k < n; ++k) {
+                const size_t v = (start + k) % n;
+                if (v != self && take(queues[v], false, best + 1, false, out)) return true;
+            }
+        }
+        if (take(own, true, 0, precise, out)) {
+            stolen = false;
+            return true;
+        }
+        for (size_t k = 0; k < n; ++k) {
+            const size_t v = (start + k) % n;
+            if (v != self && take(queues[v], false, 0, precise, out)) return true;
+        }
+        return false;
+    }
+
+    // True if a band above 'band' is queued anywhere (stats only: O(workers))
+    bool higherBandQueued(int band) const {
+        for (const WorkerQueue& q : queues)
+            if (q.mask.load(std::memory_order_relaxed) >> (band + 1)) return true;
+        return false;
+    }
+
+    static void runAndRecycle(TaskNode* task, WorkStealingPool& pool) {
+        try {
+            task->func(); // submit()ted tasks never throw here: packaged_task keeps it
+        } catch (...) {
+            pool.reportException(std::current_exception());
+        }
+        task->func.reset();   // release captures before recycling the node
+        TaskNodePool::release(task);
+    }
+
+    void execute(size_t worker, TaskNode* task, bool stolen) {
+        const unsigned mode = instrumentation.load(std::memory_order_relaxed);
+        if (mode == 0) {
+            runAndRecycle(task, *this);
+            return;
+        }
+        if (worker == EXTERNAL) {
+            runAndRecycle(task, *this);
+            externalTasks.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        const bool stats = mode & STATS, trace = mode & TRACE;
+        const uint64_t start = nowNs();
+        LiveStats& l = live[worker];
+        if (stats) {
+            if (task->enqueuedAt && start > task->enqueuedAt)
+                bump(l.waitNs[histogramBucket(start - task->enqueuedAt)]);
+            if (higherBandQueued(bandOf(task->priority))) bump(l.inversions);
+        }
+        const int priority = task->priority;
+        runAndRecycle(task, *this);
+        const uint64_t dur = nowNs() - start;
+        if (stats) {
+            bump(l.tasks);
+            if (stolen) bump(l.stolen);
+            bump(l.busyNs, dur);
+            bump(l.runNs[histogramBucket(dur)]);
+        }
+        if (trace) record(worker, TraceEvent{start, dur, priority, stolen, false});
+    }
+
+    void reportException(std::exception_ptr e) {
+        exceptionCount.fetch_add(1, std::memory_order_relaxed);
+        if (exceptionHandler) {
+            exceptionHandler(e);
+            return;
+        }
+        try {
+            std::rethrow_exception(e);
+        } catch (const std::exception& ex) {
+            std::cerr << "[WorkStealingPool] Unhandled exception in task: " << ex.what() << "\n";
+        } catch (...) {
+            std::cerr << "[WorkStealingPool] Unhandled non-standard exception in task.\n";
+        }
+    }
+
+    void record(size_t worker, const TraceEvent& e) {
+        TraceBuffer& t = traces[worker];
+        const unsigned generation = traceGeneration.load(std::memory_order_acquire);
+        if (t.generation.load(std::memory_order_relaxed) != generation) {
+            t.capacity = traceCapacity.load(std::memory_order_relaxed);
+            t.events.reset(new TraceEvent[t.capacity]);
+            t.count.store(0, std::memory_order_relaxed);
+            t.dropped.store(0, std::memory_order_relaxed);
+            t.generation.store(generation, std::memory_order_release);
+        }
+        const size_t n = t.count.load(std::memory_order_relaxed);
+        if (n == t.capacity) {
+            t.dropped.store(t.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+        t.events[n] = e;
+        t.count.store(n + 1, std::memory_order_release);
+    }
+
+    void workerLoop(size_t self) {
+        currentPool = this;
+        currentIndex = self;
+        TaskNode* task = nullptr;
+        bool stolen = false;
+        unsigned idle = 0, pops = 0;
+        uint64_t idleSince = 0;   // set while stats are on and no task was found
+        while (true) {
+            if (findTask(self, task, false, pops, stolen)) {
+                if (idleSince) {
+                    bump(live[self].idleNs, nowNs() - idleSince);
+                    idleSince = 0;
+                }
+                execute(self, task, stolen);
+                idle = 0;
+                continue;
+            }
+            if (!idleSince && (instrumentation.load(std::memory_order_relaxed) & STATS)) idleSince = nowNs();
+            if (++idle < SPIN_ROUNDS) {
+                std::this_thread::yield();
+                continue;
+            }
+            idle = 0;
+
+            // Park; the locked rescan closes the race with push()
+            std::unique_lock<std::mutex> lock(parkMutex);
+            sleepers.fetch_add(1);
+            const bool found = findTask(self, task, true, pops, stolen);
+            if (!found) {
+                if (stop) {
+                    sleepers.fetch_sub(1);
+                    return;
+                }
+                const unsigned mode = instrumentation.load(std::memory_order_relaxed);
+                const bool trace = mode & TRACE;
+                const uint64_t parkedAt = trace ? nowNs() : 0;
+                if (mode & STATS) bump(live[self].parks);
+                parkCv.wait(lock);
+                if (trace) record(self, TraceEvent{parkedAt, nowNs() - parkedAt, 0, false, true});
+            }
+            sleepers.fetch_sub(1);
+            lock.unlock();
+            if (found) {
+                if (idleSince) {
+                    bump(live[self].idleNs, nowNs() - idleSince);
+                    idleSince = 0;
+                }
+                execute(self, task, stolen);
+            }
+        }
+    }
+
+    std::vector<WorkerQueue> queues;
+    std::vector<LiveStats> live;
+    std::vector<TraceBuffer> traces;
+    std::vector<std::thread> workers;
+    std::mutex parkMutex;
+    std::condition_variable parkCv;
+    std::atomic<int> sleepers{0};
+    bool stop = false;
+
+    std::function<void(std::exception_ptr)> exceptionHandler;
+    enum : unsigned { STATS = 1, TRACE = 2 };
+    std::atomic<unsigned> instrumentation{0};   // STATS | TRACE; 0 keeps the plain path
+    std::atomic<size_t> traceCapacity{0};
+    std::atomic<uint64_t> traceEpoch{0};   // trace timestamps are relative to startTrace()
+    std::atomic<unsigned> traceGeneration{0};
+    std::atomic<uint64_t> externalTasks{0}, exceptionCount{0};
+};
+
+// === Task graph (DAG) execution ===
+// submit() with a dependency parks a worker inside dep.get() until the parent
+// finishes, so a deep chain can deadlock a small pool. A TaskGraph instead
+// gives every node a counter of unfinished predecessors: a node is handed to
+// the pool only when its counter reaches zero, so no worker ever waits.
+class TaskGraph {
+public:
+    using NodeId = size_t;
+
+    // Adds a node that runs after every node in 'after'
+    NodeId add(std::function<void()> work, int priority = 0, std::initializer_list<NodeId> after = {}) {
+        checkIdle();
+        nodes.push_back(Node{std::move(work), priority, {}, 0});
+        const NodeId id = nodes.size() - 1;
+        for (NodeId before : after) precede(before, id);
+        return id;
+    }
+
+    // 'after' may only start once 'before' has finished
+    void precede(NodeId before, NodeId after) {
+        checkIdle();
+        if (before >= nodes.size() || after >= nodes.size() || before == after)
+            throw std::invalid_argument("TaskGraph: invalid edge");
+        nodes[before].successors.push_back(after);
+        ++nodes[after].predecessors;
+    }
+
+    size_t size() const { return nodes.size(); }
+
+    // Starts every node without predecessors on 'pool'. The future becomes
+    // ready once all nodes have finished or been skipped; it carries the first
+    // exception thrown by a node, which also cancels the nodes not yet started.
+    template <class Pool>
+    std::future<void> run(Pool& pool) {
+        checkIdle();
+        checkAcyclic();
+        pending.reset(new std::atomic<size_t>[nodes.size()]);
+        for (size_t i = 0; i < nodes.size(); ++i)
+            pending[i].store(nodes[i].predecessors, std::memory_order_relaxed);
+        remaining.store(nodes.size());
+        executed.store(0);
+        cancelled.store(false);
+        error = nullptr;
+        done = std::promise<void>();
+        std::future<void> fut = done.get_future();
+        if (nodes.empty()) {
+            done.set_value();
+            return fut;
+        }
+        running.store(true);
+        for (NodeId id = 0; id < nodes.size(); ++id)
+            if (nodes[id].predecessors == 0) schedule(pool, id);
+        return fut;
+    }
+
+    // Nodes that have not started yet are skipped; running ones finish
+    void cancel() { cancelled.store(true); }
+    bool isCancelled() const { return cancelled.load(); }
+
+    // Number of node bodies that ran to completion in the last run
+    size_t executedCount() const { return executed.load(); }
+
+private:
+    struct Node {
+        std::function<void()> work;
+        int priority;
+        std::vector<NodeId> successors;
+        size_t predecessors;
+    };
+
+    void checkIdle() const {
+        if (running.load())
+            throw std::logic_error("TaskGraph: graph is running");
+    }
+
+    // Kahn's algorithm; a cycle would leave nodes that never become ready
+    void checkAcyclic() const {
+        std::vector<size_t> indegree(nodes.size());
+        std::vector<NodeId> ready;
+        for (NodeId id = 0; id < nodes.size(); ++id)
+            if ((indegree[id] = nodes[id].predecessors) == 0) ready.push_back(id);
+        size_t visited = 0;
+        while (!ready.empty()) {
+            NodeId id = ready.back();
+            ready.pop_back();
+            ++visited;
+            for (NodeId s : nodes[id].successors)
+                if (--indegree[s] == 0) ready.push_back(s);
+        }
+        if (visited != nodes.size())
+            throw std::invalid_argument("TaskGraph: dependency cycle");
+    }
+
+    template <class Pool>
+    void schedule(Pool& pool, NodeId id) {
+        pool.post([this, &pool, id] { runFrom(pool, id); }, nodes[id].priority);
+    }
+
+    // Runs a node, then releases its successors. The first successor that
+    // becomes ready continues on this worker; the others go to the pool.
+    template <class Pool>
+    void runFrom(Pool& pool, NodeId id) {
+        while (true) {
+            if (!cancelled.load(std::memory_order_relaxed)) {
+                try {
+                    nodes[id].work();
+                    executed.fetch_add(1, std::memory_order_relaxed);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!error) error = std::current_exception();
+                    cancelled.store(true);
+                }
+            }
+
+            NodeId next = nodes.size();
+            for (NodeId s : nodes[id].successors) {
+                if (pending[s].fetch_sub(1, std::memory_order_acq_rel) != 1) continue;
+                if (next == nodes.size()) next = s;
+                else schedule(pool, s);
+            }
+            // Once another worker takes 'remaining' to zero the graph may be
+            // destroyed, so nothing may be read from it after the decrement
+            const bool hasNext = next != nodes.size();
+            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                finish();
+                return;
+            }
+            if (!hasNext) return;
+            id = next;
+        }
+    }
+
+    // The promise is moved out first: once it is ready the graph may be run
+    // again or destroyed, so neither 'done' nor 'running' is touched after
+    void finish() {
+        std::promise<void> result = std::move(done);
+        std::exception_ptr e = error;
+        running.store(false);
+        if (e) result.set_exception(e);
+        else result.set_value();
+    }
+
+    std::vector<Node> nodes;
+    std::unique_ptr<std::atomic<size_t>[]> pending;
+    std::atomic<size_t> remaining{0}, executed{0};
+    std::atomic<bool> cancelled{false}, running{false};
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    std::promise<void> done;
+};
+
+// === Parallel algorithms ===
+// A loop over [begin, end) is split recursively: each split posts the upper
+// half to the pool and keeps the lower half, until a piece is no larger than
+// the grain. Pieces posted from a worker land on that worker's own deque and
+// the waiting thread runs queued tasks instead of blocking, so nested loops
+// share the pool's threads rather than adding more.
+
+// About 8 pieces per participating thread, enough to even out uneven pieces
+inline size_t autoGrain(const WorkStealingPool& pool, size_t n) {
+    return std::max<size_t>(1, n / (8 * (pool.size() + 1)));
+}
+
+// Default chunk size of parallelReduce and parallelScan. Their chunking
+// decides the floating-point rounding, so unlike autoGrain it does not
+// depend on the pool size: results are the same on every machine.
+constexpr size_t REDUCE_GRAIN = 1 << 14;
+
+template <class Body>
+class RangeSplitter {
+public:
+    RangeSplitter(WorkStealingPool& p, Body& b, size_t g) : pool(p), body(b), grain(g) {}
+
+    void run(size_t lo, size_t hi) {
+        try {
+            while (hi - lo > grain) {
+                const size_t mid = lo + (hi - lo) / 2;
+                pending.fetch_add(1, std::memory_order_relaxed);
+                try {
+                    pool.post([this, mid, hi] {
+                        run(mid, hi);
+                        pending.fetch_sub(1, std::memory_order_release);
+                    });
+                } catch (...) {
+                    pending.fetch_sub(1, std::memory_order_relaxed);
+                    throw;
+                }
+                hi = mid;
+            }
+            body(lo, hi);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) error = std::current_exception();
+        }
+    }
+
+    // Helps the pool until every posted piece has finished
+    void join() {
+        while (pending.load(std::memory_order_acquire) != 0)
+            if (!pool.runPendingTask()) std::this_thread::yield();
+        if (error) std::rethrow_exception(error);
+    }
+
+private:
+    WorkStealingPool& pool;
+    Body& body;
+    const size_t grain;
+    std::atomic<size_t> pending{0};
+    std::mutex errorMutex;
+    std::exception_ptr error;
+};
+
+// body(lo, hi) over pieces of [begin, end); grain = 0 picks one automatically.
+// Returns when all pieces are done; the first exception is rethrown.
+template <class Body>
+void parallelForRange(WorkStealingPool& pool, size_t begin, size_t end, Body&& body, size_t grain = 0) {
+    if (begin >= end) return;
+    if (grain == 0) grain = autoGrain(pool, end - begin);
+    RangeSplitter<std::remove_reference_t<Body>> splitter(pool, body, grain);
+    splitter.run(begin, end);
+    splitter.join();
+}
+
+// body(i) for every i in [begin, end)
+template <class Body>
+void parallelFor(WorkStealingPool& pool, size_t begin, size_t end, Body&& body, size_t grain = 0) {
+    parallelForRange(pool, begin, end, [&body](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; ++i) body(i);
+    }, grain);
+}
+
+// Cuts [begin, end) into chunks of 'grain'; body(lo, hi) returns the value of
+// one chunk, and the chunk values are folded in index order with combine.
+// For a given grain the result does not depend on scheduling, which keeps
+// floating-point sums reproducible run to run.
+template <class T, class Body, class Combine>
+T parallelReduce(WorkStealingPool& pool, size_t begin, size_t end, T identity,
+                 Body&& body, Combine&& combine, size_t grain = REDUCE_GRAIN) {
+    if (begin >= end) return identity;
+    grain = std::max<size_t>(1, grain);
+    const size_t chunks = (end - begin + grain - 1) / grain;
+    std::vector<T> partial(chunks, identity);
+    parallelFor(pool, 0, chunks, [&](size_t c) {
+        partial[c] = body(begin + c * grain, std::min(end, begin + (c + 1) * grain));
+    }, 1);
+    T result = identity;
+    for (const T& p : partial) result = combine(result, p);
+    return result;
+}
+
+// Inclusive scan: out[i] = in[0] op ... op in[i]; 'in' and 'out' may alias.
+// Two passes over the same chunks: chunk totals, then each chunk rescans its
+// input starting from the total of the chunks before it.
+template <class T, class Op>
+void parallelScan(WorkStealingPool& pool, const T* in, T* out, size_t n, T identity, Op op,
+                  size_t grain = REDUCE_GRAIN) {
+    if (n == 0) return;
+    grain = std::max<size_t>(1, grain);
+    const size_t chunks = (n + grain - 1) / grain;
+    std::vector<T> offset(chunks, identity);
+    parallelFor(pool, 0, chunks, [&](size_t c) {
+        T acc = identity;
+        for (size_t i = c * grain, e = std::min(n, i + grain); i < e; ++i) acc = op(acc, in[i]);
+        offset[c] = acc;
+    }, 1);
+    T carry = identity;
+    for (T& o : offset) {
+        T total = o;
+        o = carry;
+        carry = op(carry, total);
+    }
+    parallelFor(pool, 0, chunks, [&](size_t c) {
+        T acc = offset[c];
+        for (size_t i = c * grain, e = std::min(n, i + grain); i < e; ++i) out[i] = acc = op(acc, in[i]);
+    }, 1);
+}
+
+// === Coroutine tasks (C++20) ===
+// A Task<T> is a lazy coroutine: it starts when awaited, and finishing
+// resumes the awaiting coroutine directly (symmetric transfer), so a chain
+// of awaits never blocks a thread. Threads are only switched by
+// co_await scheduleOn(pool, priority), which posts the rest of the
+// coroutine to the pool with the usual priority. Exceptions travel to the
+// awaiting coroutine and are rethrown by co_await.
+#ifdef THREADPOOL_COROUTINES
+
+template <class T = void>
+class Task;
+
+template <class T>
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+    std::exception_ptr error;
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <class P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+            return h.promise().continuation;
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { error = std::current_exception(); }
+};
+
+template <class T>
+struct TaskPromise : TaskPromiseBase<T> {
+    std::optional<T> value;
+    Task<T> get_return_object();
+    void return_value(T v) { value.emplace(std::move(v)); }
+    T result() {
+        if (this->error) std::rethrow_exception(this->error);
+        return std::move(*value);
+    }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase<void> {
+    Task<void> get_return_object();
+    void return_void() {}
+    void result() {
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+template <class T>
+class Task {
+public:
+    using promise_type = TaskPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Task() = default;
+    explicit Task(Handle h) : handle(h) {}
+    Task(Task&& o) noexcept : handle(std::exchange(o.handle, {})) {}
+    Task& operator=(Task&& o) noexcept {
+        if (this != &o) {
+            if (handle) handle.destroy();
+            handle = std::exchange(o.handle, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() { if (handle) handle.destroy(); }
+
+    bool done() const { return !handle || handle.done(); }
+
+    // co_await task: starts it if needed, then yields its value or rethrows
+    auto operator co_await() noexcept {
+        struct Awaiter {
+            Handle h;
+            bool await_ready() const noexcept { return h.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                h.promise().continuation = awaiting;
+                return h;
+            }
+            T await_resume() { return h.promise().result(); }
+        };
+        return Awaiter{handle};
+    }
+
+    // Like co_await, but leaves the result (or exception) in the task
+    auto whenReady() noexcept {
+        struct Awaiter {
+            Handle h;
+            bool await_ready() const noexcept { return h.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                h.promise().continuation = awaiting;
+                return h;
+            }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{handle};
+    }
+
+private:
+    Handle handle;
+};
+
+template <class T>
+Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+// Eager coroutine that frees itself when it finishes; used to drive tasks
+// from non-coroutine code
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+// co_await scheduleOn(pool, priority): the coroutine continues as a task on
+// 'pool' (ThreadPool or WorkStealingPool), queued with 'priority'
+template <class Pool>
+struct ScheduleOn {
+    Pool& pool;
+    int priority;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) { pool.post([h] { h.resume(); }, priority); }
+    void await_resume() const noexcept {}
+};
+
+template <class Pool>
+ScheduleOn<Pool> scheduleOn(Pool& pool, int priority = 0) {
+    return ScheduleOn<Pool>{pool, priority};
+}
+
+// Runs f() as a pool task and yields its result: co_await asyncRun(pool, f)
+template <class Pool, class F>
+auto asyncRun(Pool& pool, F f, int priority = 0) -> Task<decltype(f())> {
+    co_await scheduleOn(pool, priority);
+    co_return f();
+}
+
+// Blocks a thread that is not a pool worker until 'task' is done
+template <class T>
+T syncWait(Task<T> task) {
+    std::promise<T> done;
+    std::future<T> fut = done.get_future();
+    [](Task<T> t, std::promise<T> p) -> DetachedTask {
+        try {
+            if constexpr (std::is_void_v<T>) {
+                co_await t;
+                p.set_value();
+            } else {
+                p.set_value(co_await t);
+            }
+        } catch (...) {
+            p.set_exception(std::current_exception());
+        }
+    }(std::move(task), std::move(done));
+    return fut.get();
+}
+
+// Starts every task and resumes the awaiting coroutine when the last one
+// finishes. The count starts at n + 1 so that a task finishing while the
+// others are still being started cannot resume the awaiter early.
+template <class T>
+struct WhenAllAwaiter {
+    std::vector<Task<T>>& tasks;
+    std::atomic<size_t> remaining{0};
+    std::coroutine_handle<> awaiting{};
+
+    bool await_ready() const noexcept { return tasks.empty(); }
+
+    bool await_suspend(std::coroutine_handle<> h) {
+        awaiting = h;
+        remaining.store(tasks.size() + 1);
+        for (Task<T>& t : tasks) watch(t, this);
+        return remaining.fetch_sub(1) != 1;   // false: all done already, continue now
+    }
+
+    void await_resume() const noexcept {}
+
+    static DetachedTask watch(Task<T>& t, WhenAllAwaiter* self) {
+        co_await t.whenReady();
+        if (self->remaining.fetch_sub(1) == 1) self->awaiting.resume();
+    }
+};
+
+template <class T>
+using WhenAllResult = std::conditional_t<std::is_void_v<T>, void, std::vector<T>>;
+
+// Runs the tasks concurrently (each one decides where to run with
+// scheduleOn) and yields their results in order; the first exception in
+// index order is rethrown once all have finished
+template <class T>
+Task<WhenAllResult<T>> whenAll(std::vector<Task<T>> tasks) {
+    co_await WhenAllAwaiter<T>{tasks};
+    if constexpr (std::is_void_v<T>) {
+        for (Task<T>& t : tasks) co_await t;
+    } else {
+        std::vector<T> results;
+        results.reserve(tasks.size());
+        for (Task<T>& t : tasks) results.push_back(co_await t);
+        co_return results;
+    }
+}
+
+// Shared with the watchers: the losing tasks keep running after whenAny
+// returns, so the tasks live until the last watcher is done with them
+template <class T>
+struct WhenAnyState {
+    std::vector<Task<T>> tasks;
+    std::atomic<size_t> winner{SIZE_MAX};
+    std::atomic<int> gate{2};   // the winner and the end of await_suspend
+    std::coroutine_handle<> awaiting;
+};
+
+template <class T>
+struct WhenAnyAwaiter {
+    // A reference, not a copy: g++ 12 can destroy awaiter temporaries twice
+    const std::shared_ptr<WhenAnyState<T>>& state;
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> h) {
+        state->awaiting = h;
+        for (size_t i = 0; i < state->tasks.size(); ++i) watch(state, i);
+        return state->gate.fetch_sub(1) != 1;
+    }
+
+    size_t await_resume() const noexcept { return state->winner.load(); }
+
+    static DetachedTask watch(std::shared_ptr<WhenAnyState<T>> s, size_t i) {
+        co_await s->tasks[i].whenReady();
+        size_t none = SIZE_MAX;
+        if (s->winner.compare_exchange_strong(none, i) && s->gate.fetch_sub(1) == 1)
+            s->awaiting.resume();
+    }
+};
+
+template <class T>
+using WhenAnyResult = std::conditional_t<std::is_void_v<T>, size_t, std::pair<size_t, T>>;
+
+// Yields the index (and value) of the first task to finish, or rethrows its
+// exception. The other tasks are not cancelled; their results are dropped.
+template <class T>
+Task<WhenAnyResult<T>> whenAny(std::vector<Task<T>> tasks) {
+    if (tasks.empty()) throw std::invalid_argument("whenAny: no tasks");
+    auto state = std::make_shared<WhenAnyState<T>>();
+    state->tasks = std::move(tasks);
+    const size_t first = co_await WhenAnyAwaiter<T>{state};
+    if constexpr (std::is_void_v<T>) {
+        co_await state->tasks[first];
+        co_return first;
+    } else {
+        T value = co_await state->tasks[first];
+        co_return std::pair<size_t, T>(first, std::move(value));
+    }
+}
+
+#endif // THREADPOOL_COROUTINES
+
 // === Demonstration code ===
+template <class Pool>
 void runExample() {
-    ThreadPool pool(3);
+    Pool pool(3);
 
     // T1: Low priority (1)
     auto t1 = pool.submit([] {
@@ -133,7 +1420,512 @@ void runExample() {
     t5.get(); // Wait for final task
 }
 
-int main() {
-    runExample();
+// Builds a 10000-node DAG (100 layers of 100 nodes, each node after up to 3
+// nodes of the layer above), or a 10000-node chain, and checks on 'Pool' with
+// 2 threads that every node starts only after all of its predecessors
+template <class Pool>
+void runLargeGraph(const char* poolName, bool chain) {
+    const size_t layers = 100, width = 100, n = layers * width;
+    TaskGraph graph;
+    std::unique_ptr<std::atomic<bool>[]> finished(new std::atomic<bool>[n]);
+    std::vector<std::vector<size_t>> preds(n);
+    std::atomic<size_t> violations{0};
+    unsigned seed = 12345;
+    for (size_t i = 0; i < n; ++i) {
+        finished[i].store(false);
+        if (chain) {
+            if (i > 0) preds[i].push_back(i - 1);
+        } else if (i >= width) {
+            const size_t above = (i / width - 1) * width;
+            for (int k = 0; k < 3; ++k) {
+                seed = seed * 1103515245u + 12345u;
+                const size_t p = above + (seed >> 8) % width;
+                if (std::find(preds[i].begin(), preds[i].end(), p) == preds[i].end())
+                    preds[i].push_back(p);
+            }
+        }
+        graph.add([&, i] {
+            for (size_t p : preds[i])
+                if (!finished[p].load()) violations.fetch_add(1);
+            finished[i].store(true);
+        });
+        for (size_t p : preds[i]) graph.precede(p, i);
+    }
+
+    Pool pool(2);
+    auto start = std::chrono::high_resolution_clock::now();
+    graph.run(pool).get();
+    double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "[Graph] " << n << "-node " << (chain ? "chain" : "layered DAG") << " on "
+              << poolName << "(2): " << graph.executedCount() << " nodes ran, "
+              << violations.load() << " ordering violations, " << ms << " ms\n";
+}
+
+void runGraphExample() {
+    WorkStealingPool pool(2);
+
+    // Fan-out / fan-in: A -> {B, C} -> D
+    TaskGraph diamond;
+    auto a = diamond.add([] { std::cout << "[Graph] A (fan-out)\n"; });
+    auto b = diamond.add([] { std::cout << "[Graph] B after A\n"; }, 5, {a});
+    auto c = diamond.add([] { std::cout << "[Graph] C after A\n"; }, 1, {a});
+    diamond.add([] { std::cout << "[Graph] D after B and C (fan-in)\n"; }, 0, {b, c});
+    diamond.run(pool).get();
+
+    runLargeGraph<WorkStealingPool>("WorkStealingPool", false);
+    runLargeGraph<WorkStealingPool>("WorkStealingPool", true);
+    runLargeGraph<ThreadPool>("ThreadPool", true);
+
+    // A graph may be run again, or destroyed, as soon as its future is ready
+    size_t shortLivedRuns = 0;
+    for (int round = 0; round < 200; ++round) {
+        TaskGraph g;
+        auto first = g.add([] {});
+        g.add([] {}, 0, {first});
+        g.add([] {}, 0, {first});
+        g.run(pool).get();
+        g.run(pool).get();
+        shortLivedRuns += g.executedCount();
+    }
+    std::cout << "[Graph] 200 short-lived graphs, run twice each: "
+              << (shortLivedRuns == 600 ? "Passed\n" : "FAILED\n");
+
+    // Cancellation from inside the graph: nodes after #10 never start
+    TaskGraph chain;
+    TaskGraph::NodeId prev = 0;
+    for (size_t i = 0; i < 100; ++i) {
+        auto id = chain.add([&chain, i] { if (i == 10) chain.cancel(); });
+        if (i > 0) chain.precede(prev, id);
+        prev = id;
+    }
+    chain.run(pool).get();
+    std::cout << "[Graph] Cancelled at node 10 of 100: " << chain.executedCount() << " nodes ran\n";
+
+    // A throwing node cancels the rest and its exception reaches the caller
+    TaskGraph failing;
+    auto bad = failing.add([] { throw std::runtime_error("node failed"); });
+    failing.add([] { std::cout << "[Graph] never printed\n"; }, 0, {bad});
+    try {
+        failing.run(pool).get();
+    } catch (const std::exception& ex) {
+        std::cerr << "[Main] Caught exception from graph: " << ex.what()
+                  << " (" << failing.executedCount() << " nodes ran)\n";
+    }
+}
+
+void runAlgorithmExample() {
+    WorkStealingPool pool(3);
+    const size_t n = 1000000;
+
+    std::vector<double> v(n);
+    parallelFor(pool, 0, n, [&](size_t i) { v[i] = double(i); });
+    double sum = parallelReduce(pool, 0, n, 0.0, [&](size_t lo, size_t hi) {
+        double s = 0;
+        for (size_t i = lo; i < hi; ++i) s += v[i];
+        return s;
+    }, [](double a, double b) { return a + b; });
+    std::cout << "[Algo] parallelReduce sum of 0.." << n - 1 << " = " << std::setprecision(0) << std::fixed
+              << sum << (sum == double(n) * (n - 1) / 2 ? "  Passed\n" : "  FAILED\n");
+
+    std::vector<long long> in(n), out(n), expected(n);
+    for (size_t i = 0; i < n; ++i) in[i] = static_cast<long long>(i % 7) - 3;
+    std::partial_sum(in.begin(), in.end(), expected.begin());
+    parallelScan(pool, in.data(), out.data(), n, 0LL, [](long long a, long long b) { return a + b; });
+    std::cout << "[Algo] parallelScan matches std::partial_sum: " << (out == expected ? "Passed\n" : "FAILED\n");
+
+    // Nested loops reuse the pool's threads (plus the caller) and never add more
+    std::mutex idsMutex;
+    std::set<std::thread::id> ids;
+    std::atomic<size_t> cells{0};
+    parallelFor(pool, 0, 64, [&](size_t) {
+        parallelFor(pool, 0, 1000, [&](size_t) {
+            cells.fetch_add(1, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(idsMutex);
+            ids.insert(std::this_thread::get_id());
+        });
+    });
+    std::cout << "[Algo] Nested 64 x 1000 loop: " << cells.load() << " cells on " << ids.size()
+              << " threads (pool of " << pool.size() << " + caller)"
+              << (cells.load() == 64000 && ids.size() <= pool.size() + 1 ? "  Passed\n" : "  FAILED\n");
+
+    try {
+        parallelFor(pool, 0, n, [](size_t i) {
+            if (i == 12345) throw std::runtime_error("bad element 12345");
+        });
+    } catch (const std::exception& ex) {
+        std::cerr << "[Main] Caught exception from parallelFor: " << ex.what() << "\n";
+    }
+}
+
+// === Throughput benchmark ===
+template <class F>
+double secondsFor(F&& f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+thread_local double benchSink = 0;   // keeps the task bodies from being optimized out
+
+// A chain of 'iterations' dependent multiply-adds; 0 makes an empty task
+void burn(size_t iterations) {
+    double x = benchSink;
+    for (size_t i = 0; i < iterations; ++i) x = x * 0.999999 + 1e-6;
+    benchSink = x;
+}
+
+// Mixed workload for the stats snapshot and the trace: a parallel loop,
+// a burst of prioritized tasks and one task that throws
+void runInstrumentedWorkload(WorkStealingPool& pool) {
+    std::vector<double> v(1 << 20);
+    parallelFor(pool, 0, v.size(), [&](size_t i) { v[i] = std::sqrt(double(i)); });
+    std::atomic<int> left{300};
+    for (int i = 0; i < 300; ++i)
+        pool.post([&left] { burn(2000); left.fetch_sub(1); }, i % 10);
+    pool.post([] { throw std::runtime_error("instrumented failure"); });
+    while (left.load() > 0) std::this_thread::yield();
+}
+
+// Returns once every worker has finished the task it was running: each one
+// ends up holding one of size() tasks that wait for each other. Used before
+// reading trace buffers, which a worker fills in after its task returns.
+void drainWorkers(WorkStealingPool& pool) {
+    std::atomic<size_t> arrived{0}, left{pool.size()};
+    for (size_t i = 0; i < pool.size(); ++i)
+        pool.post([&arrived, &left, &pool] {
+            arrived.fetch_add(1);
+            while (arrived.load() < pool.size()) std::this_thread::yield();
+            left.fetch_sub(1);
+        });
+    while (left.load() > 0) std::this_thread::yield();
+}
+
+void runInstrumentationExample() {
+    std::atomic<int> handled{0};   // outlives the pool, whose workers call the handler
+    WorkStealingPool pool(3);
+    pool.setExceptionHandler([&handled](std::exception_ptr e) {
+        try {
+            std::rethrow_exception(e);
+        } catch (const std::exception& ex) {
+            std::cerr << "[Stats] Exception handler: " << ex.what() << "\n";
+        }
+        handled.fetch_add(1);
+    });
+    pool.enableStats(true);
+    runInstrumentedWorkload(pool);
+    while (handled.load() == 0) std::this_thread::yield();   // the throwing task
+    pool.snapshot().print(std::cout);
+}
+
+#ifdef THREADPOOL_COROUTINES
+// A pipeline that suspends instead of blocking: each stage hops onto the
+// pool with its own priority and awaits the previous result
+Task<int> pipeline(WorkStealingPool& pool, int input) {
+    co_await scheduleOn(pool, 5);
+    int doubled = input * 2;
+    int squared = co_await asyncRun(pool, [doubled] { return doubled * doubled; }, 8);
+    co_return squared + 1;
+}
+
+Task<int> sleepy(WorkStealingPool& pool, int ms, int value) {
+    co_await scheduleOn(pool);
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    co_return value;
+}
+
+Task<void> failing(WorkStealingPool& pool) {
+    co_await scheduleOn(pool);
+    throw std::runtime_error("coroutine failed");
+}
+
+void runCoroutineExample() {
+    WorkStealingPool pool(3);
+    std::cout << "[Coro] pipeline(3) = " << syncWait(pipeline(pool, 3)) << "\n";
+
+    std::vector<Task<int>> all;
+    for (int i = 1; i <= 4; ++i) all.push_back(pipeline(pool, i));
+    std::vector<int> results = syncWait(whenAll(std::move(all)));
+    std::cout << "[Coro] whenAll(pipeline(1..4)) =";
+    for (int r : results) std::cout << " " << r;
+    std::cout << "\n";
+
+    std::vector<Task<int>> race;
+    race.push_back(sleepy(pool, 60, 1));
+    race.push_back(sleepy(pool, 5, 2));
+    race.push_back(sleepy(pool, 30, 3));
+    auto [index, value] = syncWait(whenAny(std::move(race)));
+    std::cout << "[Coro] whenAny: task " << index << " finished first with " << value << "\n";
+
+    try {
+        syncWait(failing(pool));
+    } catch (const std::exception& ex) {
+        std::cerr << "[Main] Caught exception from coroutine: " << ex.what() << "\n";
+    }
+}
+#endif
+
+// Writes a Chrome trace of the instrumented workload to 'path'
+int writeTraceFile(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Cannot open " << path << "\n";
+        return 1;
+    }
+    std::atomic<int> handled{0};
+    WorkStealingPool pool(std::max(2u, std::thread::hardware_concurrency()));
+    pool.setExceptionHandler([&handled](std::exception_ptr) { handled.fetch_add(1); });
+    pool.startTrace();
+    runInstrumentedWorkload(pool);
+    while (handled.load() == 0) std::this_thread::yield();
+    pool.stopTrace();
+    drainWorkers(pool);   // the drain tasks start after stopTrace, so are not traced
+    pool.writeChromeTrace(out);
+    std::cout << "Wrote " << path << " (open in chrome://tracing or ui.perfetto.dev)\n";
+    return 0;
+}
+
+// Millions of tasks per second. Either main submits every task, or main
+// submits a few roots and each root spawns its share from inside the pool.
+template <class Pool>
+double tasksPerSecond(size_t threads, size_t tasks, size_t work, bool nested) {
+    Pool pool(threads);
+    std::atomic<size_t> done{0};
+    const size_t roots = threads * 4, perRoot = tasks / roots;
+    const size_t total = nested ? roots * perRoot : tasks;
+    auto body = [&done, work] {
+        burn(work);
+        done.fetch_add(1, std::memory_order_relaxed);
+    };
+    double t = secondsFor([&] {
+        if (nested) {
+            for (size_t r = 0; r < roots; ++r)
+                pool.submit([&pool, &body, perRoot] {
+                    for (size_t i = 0; i < perRoot; ++i) pool.submit(body);
+                });
+        } else {
+            for (size_t i = 0; i < tasks; ++i) pool.submit(body);
+        }
+        while (done.load() < total) std::this_thread::yield();
+    });
+    return total / t * 1e-6;
+}
+
+void benchmarkThroughput(size_t maxThreads) {
+    std::vector<size_t> counts;
+    for (size_t t = 1; t < maxThreads; t *= 2) counts.push_back(t);
+    counts.push_back(maxThreads);
+
+    struct Load { const char* name; size_t tasks, work; };
+    const Load loads[] = {{"tiny (empty body)", 200000, 0}, {"medium (~2us body)", 40000, 700}};
+    std::cout << std::fixed << std::setprecision(2);
+    for (const Load& load : loads) {
+        std::cout << "\nMillion tasks/sec, " << load.name << ", " << load.tasks << " tasks\n"
+                  << "        |   submitted from main    |   spawned inside the pool\n"
+                  << "threads | ThreadPool  WorkStealing | ThreadPool  WorkStealing\n";
+        for (size_t t : counts) {
+            std::cout << std::setw(7) << t << " | "
+                      << std::setw(10) << tasksPerSecond<ThreadPool>(t, load.tasks, load.work, false) << "  "
+                      << std::setw(12) << tasksPerSecond<WorkStealingPool>(t, load.tasks, load.work, false) << " | "
+                      << std::setw(10) << tasksPerSecond<ThreadPool>(t, load.tasks, load.work, true) << "  "
+                      << std::setw(12) << tasksPerSecond<WorkStealingPool>(t, load.tasks, load.work, true) << "\n";
+        }
+    }
+}
+
+// Cost of handing one tiny task to a pool with one worker: ns spent in the
+// submitting call, and heap allocations per task from submit to completion
+// (measured after a warm-up round, so pooled nodes are already in place)
+template <class SubmitOne>
+void measureSubmit(const char* name, SubmitOne submitOne) {
+    const size_t tasks = 200000;
+    std::atomic<size_t> done{0};
+    double ns = 0, allocs = 0;
+    for (int round = 0; round < 2; ++round) {
+        done.store(0);
+        allocationCount.store(0);
+        countAllocations.store(true);
+        double t = secondsFor([&] {
+            for (size_t i = 0; i < tasks; ++i) submitOne(done);
+        });
+        while (done.load() < tasks) std::this_thread::yield();
+        countAllocations.store(false);
+        ns = t / tasks * 1e9;
+        allocs = double(allocationCount.load()) / tasks;
+    }
+    std::cout << std::left << std::setw(40) << name << std::right << std::setw(10) << ns
+              << std::setw(14) << allocs << "\n";
+}
+
+void benchmarkSubmit() {
+    std::cout << std::fixed << std::setprecision(2)
+              << "\nSubmission cost, " << "tiny tasks, 1 worker\n"
+              << std::left << std::setw(40) << "path" << std::right << std::setw(10) << "ns/submit"
+              << std::setw(14) << "allocs/task" << "\n";
+    {
+        ThreadPool pool(1);
+        measureSubmit("ThreadPool::submit (before)", [&](std::atomic<size_t>& done) {
+            pool.submit([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+        });
+    }
+    {
+        ThreadPool pool(1);
+        measureSubmit("ThreadPool::post", [&](std::atomic<size_t>& done) {
+            pool.post([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+        });
+    }
+    {
+        WorkStealingPool pool(1);
+        measureSubmit("WorkStealingPool::submit (future)", [&](std::atomic<size_t>& done) {
+            pool.submit([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+        });
+    }
+    {
+        WorkStealingPool pool(1);
+        measureSubmit("WorkStealingPool::post (fire-and-forget)", [&](std::atomic<size_t>& done) {
+            pool.post([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+        });
+    }
+}
+
+// Scaling of the parallel algorithms; the calling thread helps, so a pool of
+// t threads runs each loop on t + 1 threads
+void benchmarkAlgorithms(size_t maxThreads) {
+    const size_t n = size_t(1) << 24;
+    std::vector<double> data(n), out(n);
+    for (size_t i = 0; i < n; ++i) data[i] = double(i % 1000) * 1e-3;
+
+    std::vector<size_t> counts;
+    for (size_t t = 1; t < maxThreads; t *= 2) counts.push_back(t);
+    counts.push_back(maxThreads);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "\nParallel algorithms, " << n << " doubles (ms, speedup vs 1 thread)\n"
+              << "threads |    for (sqrt)       |  reduce (sum sin)   |    scan (+)\n";
+    double base[3] = {0, 0, 0};
+    double check = 0;
+    for (size_t t : counts) {
+        WorkStealingPool pool(t);
+        double ms[3];
+        ms[0] = secondsFor([&] {
+            parallelFor(pool, 0, n, [&](size_t i) { out[i] = std::sqrt(data[i]); });
+        }) * 1e3;
+        ms[1] = secondsFor([&] {
+            check += parallelReduce(pool, 0, n, 0.0, [&](size_t lo, size_t hi) {
+                double s = 0;
+                for (size_t i = lo; i < hi; ++i) s += std::sin(data[i]);
+                return s;
+            }, [](double a, double b) { return a + b; });
+        }) * 1e3;
+        ms[2] = secondsFor([&] {
+            parallelScan(pool, data.data(), out.data(), n, 0.0, [](double a, double b) { return a + b; });
+        }) * 1e3;
+        check += out[n - 1];
+        std::cout << std::setw(7) << t;
+        for (int k = 0; k < 3; ++k) {
+            if (t == counts.front()) base[k] = ms[k];
+            std::cout << " | " << std::setw(9) << ms[k] << "  " << std::setw(6) << base[k] / ms[k] << "x";
+        }
+        std::cout << "\n";
+    }
+    std::cout << "(checksum " << check << ")\n";
+}
+
+// Cost of the instrumentation on tiny posted tasks: stats off (default),
+// stats on, and stats plus tracing
+void benchmarkInstrumentation() {
+    const size_t tasks = 400000;
+    std::cout << std::fixed << std::setprecision(2)
+              << "\nInstrumentation overhead, " << tasks << " tiny tasks, 2 workers (million tasks/sec)\n";
+    const char* modes[] = {"disabled", "stats", "stats + trace"};
+    for (int mode = 0; mode < 3; ++mode) {
+        double best = 0;
+        for (int rep = 0; rep < 3; ++rep) {
+            WorkStealingPool pool(2);
+            pool.enableStats(mode >= 1);
+            if (mode == 2) pool.startTrace(tasks);
+            std::atomic<size_t> done{0};
+            double t = secondsFor([&] {
+                for (size_t i = 0; i < tasks; ++i)
+                    pool.post([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+                while (done.load() < tasks) std::this_thread::yield();
+            });
+            best = std::max(best, tasks / t * 1e-6);
+        }
+        std::cout << "  " << std::left << std::setw(14) << modes[mode] << std::right << std::setw(8) << best << "\n";
+    }
+}
+
+#ifdef THREADPOOL_COROUTINES
+Task<size_t> hopChain(WorkStealingPool& pool, size_t steps) {
+    size_t sum = 0;
+    for (size_t i = 0; i < steps; ++i) {
+        co_await scheduleOn(pool);
+        sum += i;
+    }
+    co_return sum;
+}
+
+Task<size_t> nestedChain(size_t depth) {
+    if (depth == 0) co_return 0;
+    co_return 1 + co_await nestedChain(depth - 1);
+}
+
+// A deep sequential async chain: the future-based way submits each step
+// and blocks in get() before the next; the coroutine way suspends and hops
+// to the pool for every step, or just awaits nested tasks without hopping
+void benchmarkCoroutines() {
+    const size_t steps = 100000;
+    WorkStealingPool pool(2);
+    size_t check = 0;
+    double tFuture = secondsFor([&] {
+        for (size_t i = 0; i < steps; ++i) pool.submit([&check, i] { check += i; }).get();
+    });
+    double tHop = secondsFor([&] { check += syncWait(hopChain(pool, steps)); });
+    double tNested = secondsFor([&] { check += syncWait(nestedChain(steps / 10)); });
+    std::cout << std::fixed << std::setprecision(1)
+              << "\nDeep async chain, " << steps << " steps (ns per step)\n"
+              << "  submit().get() per step            " << std::setw(8) << tFuture / steps * 1e9 << "\n"
+              << "  co_await scheduleOn(pool) per step " << std::setw(8) << tHop / steps * 1e9 << "\n"
+              << "  nested co_await, " << steps / 10 << " levels     "
+              << std::setw(8) << tNested / (steps / 10) * 1e9 << "\n"
+              << "(checksum " << check << ")\n";
+}
+#endif
+
+// Run with --bench [threads] for the scheduler throughput comparison, or
+// with --trace <file.json> to write a Chrome trace of a sample workload
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        size_t threads = argc > 2 ? std::stoul(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+        benchmarkThroughput(std::max<size_t>(1, threads));
+        benchmarkSubmit();
+        benchmarkAlgorithms(std::max<size_t>(1, threads));
+        benchmarkInstrumentation();
+#ifdef THREADPOOL_COROUTINES
+        benchmarkCoroutines();
+#endif
+        return 0;
+    }
+    if (argc > 2 && std::string(argv[1]) == "--trace")
+        return writeTraceFile(argv[2]);
+
+    std::cout << "=== ThreadPool (global priority queue) ===\n";
+    runExample<ThreadPool>();
+    std::cout << "\n=== WorkStealingPool (per-worker priority bands) ===\n";
+    runExample<WorkStealingPool>();
+    std::cout << "\n=== TaskGraph (continuation counters, no blocked workers) ===\n";
+    runGraphExample();
+    std::cout << "\n=== Parallel algorithms (parallelFor / parallelReduce / parallelScan) ===\n";
+    runAlgorithmExample();
+    std::cout << "\n=== Scheduler stats snapshot ===\n";
+    runInstrumentationExample();
+    std::cout << "\n=== Coroutines (scheduleOn / whenAll / whenAny) ===\n";
+#ifdef THREADPOOL_COROUTINES
+    runCoroutineExample();
+#else
+    std::cout << "(build with -std=c++20 for the coroutine examples)\n";
+#endif
     return 0;
 }
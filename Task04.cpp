@@ -13,10 +13,30 @@ Provide benchmarks clearly comparing sequential versus concurrent implementation
 #include <future>
 #include <random>
 #include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <string>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <cmath>
+#include <type_traits>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "AllocationCounter.h"
+
 using namespace std;
 using namespace std::chrono;
 
-// Threshold to decide parallel or sequential
+// Fixed threshold of asyncMergeSort, the original std::async version
+// (the pool-based sorts use adaptiveThreshold() instead)
 const size_t PARALLEL_THRESHOLD = 5000;
 
 // Merge two sorted halves
@@ -42,9 +62,240 @@ void sequentialMergeSort(vector<T>& data, size_t left, size_t right) {
     merge(data, left, mid, right);
 }
 
-// Parallel merge sort with adaptive thresholding
+// === Fork/join pool ===
+// A fixed set of workers, each with its own deque of jobs. invoke(a, b)
+// pushes b, runs a, then takes b back if nobody stole it; otherwise it
+// runs other jobs until b is done, so a waiting worker never blocks and
+// no thread is created after the constructor.
+class ForkJoinPool {
+public:
+    explicit ForkJoinPool(unsigned threads = max(1u, thread::hardware_concurrency())) {
+        for (unsigned i = 0; i < max(1u, threads); ++i) queues.emplace_back(new Queue);
+        for (unsigned i = 0; i < max(1u, threads); ++i) workers.emplace_back([this, i] { workerLoop(i); });
+    }
+
+    ~ForkJoinPool() {
+        {
+            lock_guard<mutex> lock(sleepMutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for (auto& t : workers) t.join();
+    }
+
+    ForkJoinPool(const ForkJoinPool&) = delete;
+    ForkJoinPool& operator=(const ForkJoinPool&) = delete;
+
+    unsigned size() const { return unsigned(workers.size()); }
+    size_t forks() const { return forkCount.load(memory_order_relaxed); }
+    size_t steals() const { return stealCount.load(memory_order_relaxed); }
+
+    // Runs f() on a worker and waits for it (directly when called from one)
+    template<typename F>
+    void run(F&& f) {
+        if (current == this) {
+            f();
+            return;
+        }
+        RootJob<F> job(f, *this);
+        push(injected, &job);
+        unique_lock<mutex> lock(rootMutex);
+        rootDone.wait(lock, [&] { return job.done.load(); });
+        if (job.error) rethrow_exception(job.error);
+    }
+
+    // Runs a() and b(), possibly in parallel, and returns when both are done.
+    // An exception from either is rethrown after both have finished.
+    template<typename A, typename B>
+    void invoke(A&& a, B&& b) {
+        if (current != this) {
+            run([&] { invoke(a, b); });
+            return;
+        }
+        Queue& own = *queues[currentIndex];
+        ForkedJob<B> forked(b);
+        forkCount.fetch_add(1, memory_order_relaxed);
+        push(own, &forked);
+
+        exception_ptr error;
+        try {
+            a();
+        } catch (...) {
+            error = current_exception();
+        }
+        while (!forked.done.load(memory_order_acquire)) {
+            Job* job = popBack(own);
+            if (!job) job = steal(currentIndex);
+            if (job) execute(job);
+            else this_thread::yield();
+        }
+        if (!error) error = forked.error;
+        if (error) rethrow_exception(error);
+    }
+
+private:
+    // Whoever waits for a job may destroy it as soon as done is set, so
+    // finish() is the last access to it
+    struct Job {
+        virtual ~Job() = default;
+        virtual void run() = 0;
+        virtual void finish() { done.store(true, memory_order_release); }
+        atomic<bool> done{false};
+        exception_ptr error;
+    };
+
+    template<typename F>
+    struct ForkedJob : Job {
+        F& f;
+        explicit ForkedJob(F& f) : f(f) {}
+        void run() override { f(); }
+    };
+
+    // The caller of run() sleeps on rootDone instead of spinning
+    template<typename F>
+    struct RootJob : Job {
+        F& f;
+        ForkJoinPool& pool;
+        RootJob(F& f, ForkJoinPool& pool) : f(f), pool(pool) {}
+        void run() override { f(); }
+        void finish() override {
+            ForkJoinPool& p = pool;
+            {
+                lock_guard<mutex> lock(p.rootMutex);
+                done.store(true);
+            }
+            p.rootDone.notify_all();
+        }
+    };
+
+    struct Queue {
+        mutex m;
+        deque<Job*> jobs;
+    };
+
+    void push(Queue& q, Job* job) {
+        {
+            lock_guard<mutex> lock(q.m);
+            q.jobs.push_back(job);
+        }
+        queued.fetch_add(1);
+        if (sleepers.load() > 0) {
+            { lock_guard<mutex> lock(sleepMutex); }
+            wake.notify_one();
+        }
+    }
+
+    Job* popBack(Queue& q) {
+        lock_guard<mutex> lock(q.m);
+        if (q.jobs.empty()) return nullptr;
+        Job* job = q.jobs.back();
+        q.jobs.pop_back();
+        queued.fetch_sub(1);
+        return job;
+    }
+
+    Job* popFront(Queue& q) {
+        lock_guard<mutex> lock(q.m);
+        if (q.jobs.empty()) return nullptr;
+        Job* job = q.jobs.front();
+        q.jobs.pop_front();
+        queued.fetch_sub(1);
+        return job;
+    }
+
+    // Takes the oldest job of another worker (the biggest piece of work),
+    // or a job submitted from outside the pool
+    Job* steal(size_t self) {
+        for (size_t k = 1; k < queues.size(); ++k) {
+            if (Job* job = popFront(*queues[(self + k) % queues.size()])) {
+                stealCount.fetch_add(1, memory_order_relaxed);
+                return job;
+            }
+        }
+        return popFront(injected);
+    }
+
+    static void execute(Job* job) {
+        try {
+            job->run();
+        } catch (...) {
+            job->error = current_exception();
+        }
+        job->finish();
+    }
+
+    void workerLoop(size_t index) {
+        current = this;
+        currentIndex = index;
+        for (;;) {
+            Job* job = popBack(*queues[index]);
+            if (!job) job = steal(index);
+            if (job) {
+                execute(job);
+                continue;
+            }
+            unique_lock<mutex> lock(sleepMutex);
+            sleepers.fetch_add(1);
+            wake.wait(lock, [this] { return stop || queued.load() > 0; });
+            sleepers.fetch_sub(1);
+            if (stop && queued.load() == 0) return;
+        }
+    }
+
+    vector<unique_ptr<Queue>> queues;   // one per worker
+    Queue injected;                     // jobs from run() outside the pool
+    vector<thread> workers;
+    atomic<size_t> queued{0};
+    atomic<size_t> sleepers{0};
+    atomic<size_t> forkCount{0};
+    atomic<size_t> stealCount{0};
+    mutex sleepMutex;
+    condition_variable wake;
+    mutex rootMutex;
+    condition_variable rootDone;
+    bool stop = false;
+
+    static thread_local ForkJoinPool* current;
+    static thread_local size_t currentIndex;
+};
+
+thread_local ForkJoinPool* ForkJoinPool::current = nullptr;
+thread_local size_t ForkJoinPool::currentIndex = 0;
+
+// Shared by the sorts unless a pool is passed in
+ForkJoinPool& defaultPool() {
+    static ForkJoinPool pool;
+    return pool;
+}
+
+// Ranges up to this size are not split any further. About 8 pieces per
+// thread leave room for stealing to even out the load, but a piece stays
+// at least ~32 KB so a fork costs little next to the work. On one thread
+// the whole range is sorted sequentially.
+size_t adaptiveThreshold(size_t n, size_t elementSize, unsigned threads) {
+    if (threads <= 1) return n;
+    size_t perPiece = n / (size_t(threads) * 8);
+    size_t minimum = max<size_t>(32 * 1024 / elementSize, 256);
+    return max(perPiece, minimum);
+}
+
+// Threads started by asyncMergeSort, and the most alive at once
+struct AsyncThreadTelemetry {
+    static atomic<size_t> started, live, peak;
+    AsyncThreadTelemetry() {
+        started.fetch_add(1);
+        size_t now = live.fetch_add(1) + 1;
+        size_t seen = peak.load();
+        while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+    }
+    ~AsyncThreadTelemetry() { live.fetch_sub(1); }
+};
+atomic<size_t> AsyncThreadTelemetry::started{0}, AsyncThreadTelemetry::live{0}, AsyncThreadTelemetry::peak{0};
+
+// Original parallel merge sort: a new std::async thread for every split
+// above PARALLEL_THRESHOLD, so big inputs start thousands of threads
 template<typename T>
-void parallelMergeSort(vector<T>& data, size_t left, size_t right) {
+void asyncMergeSort(vector<T>& data, size_t left, size_t right) {
     if (right - left <= PARALLEL_THRESHOLD) {
         sequentialMergeSort(data, left, right);
         return;
@@ -52,13 +303,363 @@ void parallelMergeSort(vector<T>& data, size_t left, size_t right) {
 
     size_t mid = left + (right - left) / 2;
     auto leftFuture = async(launch::async, [&data, left, mid] {
-        parallelMergeSort(data, left, mid);
+        AsyncThreadTelemetry counted;
+        asyncMergeSort(data, left, mid);
     });
-    parallelMergeSort(data, mid, right);
+    asyncMergeSort(data, mid, right);
     leftFuture.wait();
     merge(data, left, mid, right);
 }
 
+template<typename T>
+void forkJoinMergeSort(vector<T>& data, size_t left, size_t right, size_t threshold, ForkJoinPool& pool) {
+    if (right - left <= threshold) {
+        sequentialMergeSort(data, left, right);
+        return;
+    }
+
+    size_t mid = left + (right - left) / 2;
+    pool.invoke([&] { forkJoinMergeSort(data, left, mid, threshold, pool); },
+                [&] { forkJoinMergeSort(data, mid, right, threshold, pool); });
+    merge(data, left, mid, right);
+}
+
+// Parallel merge sort with adaptive thresholding, on a fixed pool
+template<typename T>
+void parallelMergeSort(vector<T>& data, size_t left, size_t right, ForkJoinPool& pool = defaultPool()) {
+    size_t threshold = adaptiveThreshold(right - left, sizeof(T), pool.size());
+    if (right - left <= threshold) {
+        sequentialMergeSort(data, left, right);   // no fork: skip the hand-off to the pool
+        return;
+    }
+    pool.run([&] { forkJoinMergeSort(data, left, right, threshold, pool); });
+}
+
+// === Buffer-reusing merge sort ===
+// merge() above allocates a temporary vector on every call and copies the
+// elements. bufferedMergeSort allocates one scratch buffer up front; the
+// levels of the recursion alternate between the data and the buffer
+// (ping-pong), and elements are moved. The merges themselves are split
+// between the pool's threads too, so the last levels are not
+// single-threaded.
+
+// Below this size a range is insertion sorted
+const size_t INSERTION_THRESHOLD = 32;
+
+template<typename T>
+void insertionSort(T* first, T* last) {
+    for (T* i = first + 1; i < last; ++i) {
+        T value = move(*i);
+        T* j = i;
+        for (; j > first && value < *(j - 1); --j) *j = move(*(j - 1));
+        *j = move(value);
+    }
+}
+
+// How many of the first k elements of merge(a, b) come from a (co-rank).
+// On equal keys a goes first, which keeps the merge stable.
+template<typename T>
+size_t coRank(size_t k, const T* a, size_t m, const T* b, size_t n) {
+    size_t lo = k > n ? k - n : 0, hi = min(k, m);
+    while (lo < hi) {
+        size_t i = lo + (hi - lo) / 2, j = k - i;
+        if (j > 0 && !(b[j - 1] < a[i])) lo = i + 1;
+        else hi = i;
+    }
+    return lo;
+}
+
+// Moves the sorted ranges a[0, m) and b[0, n) into out, merged
+template<typename T>
+void mergeMove(T* a, size_t m, T* b, size_t n, T* out) {
+    T* aEnd = a + m;
+    T* bEnd = b + n;
+    while (a < aEnd && b < bEnd) *out++ = (*b < *a) ? move(*b++) : move(*a++);
+    out = move(a, aEnd, out);
+    move(b, bEnd, out);
+}
+
+// Splits the output in half, finds where the upper half starts in a and
+// b with coRank, and merges both halves in parallel, down to 'grain'
+template<typename T>
+void parallelMergeMove(T* a, size_t m, T* b, size_t n, T* out, size_t grain, ForkJoinPool& pool) {
+    size_t total = m + n;
+    if (total <= grain) {
+        mergeMove(a, m, b, n, out);
+        return;
+    }
+    size_t k = total / 2, i = coRank(k, a, m, b, n);
+    pool.invoke([&] { parallelMergeMove(a, i, b, k - i, out, grain, pool); },
+                [&] { parallelMergeMove(a + i, m - i, b + (k - i), n - (k - i), out + k, grain, pool); });
+}
+
+// === Sorting-network leaves ===
+// For int, the recursion of bufferedMergeSort stops at 16 elements
+// instead of 32, and a leaf is sorted with a 16-lane bitonic network:
+// 10 stages of compare-exchange with no data-dependent branches. With
+// AVX2 (-mavx2 or -march=native) a stage is one permute, min, max and
+// blend per 8 lanes; otherwise the same network runs on scalars.
+
+// Stage s compares lane i with lane partner[s][i]; lane i keeps the
+// larger value when takeMax[s][i] is set
+struct BitonicNetwork16 {
+    static const int stages = 10;
+    int partner[stages][16] = {};
+    int takeMax[stages][16] = {};   // 0 or -1 (an all-ones SIMD mask)
+
+    constexpr BitonicNetwork16() {
+        int s = 0;
+        for (int k = 2; k <= 16; k *= 2) {
+            for (int j = k / 2; j > 0; j /= 2, ++s) {
+                for (int i = 0; i < 16; ++i) {
+                    int other = i ^ j;
+                    bool ascending = (i & k) == 0;
+                    partner[s][i] = other;
+                    takeMax[s][i] = ((i > other) == ascending) ? -1 : 0;
+                }
+            }
+        }
+    }
+};
+
+constexpr BitonicNetwork16 bitonic16;
+
+template<typename T>
+struct HasSortingNetwork : is_same<T, int> {};
+
+#ifdef __AVX2__
+inline void sortNetwork16(int* lanes) {
+    __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes));
+    __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes + 8));
+    // Applies stage s to the 8 lanes starting at 'base'; the partner is
+    // in the same register for every distance but 8
+    auto stage = [](__m256i v, int s, int base) {
+        __m256i idx = _mm256_and_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bitonic16.partner[s] + base)),
+            _mm256_set1_epi32(7));
+        __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bitonic16.takeMax[s] + base));
+        __m256i other = _mm256_permutevar8x32_epi32(v, idx);
+        return _mm256_blendv_epi8(_mm256_min_epi32(v, other), _mm256_max_epi32(v, other), mask);
+    };
+    for (int s = 0; s < BitonicNetwork16::stages; ++s) {
+        if (bitonic16.partner[s][0] == 8) {
+            // Only the first merge step of k = 16, ascending in every lane
+            __m256i mn = _mm256_min_epi32(lo, hi);
+            hi = _mm256_max_epi32(lo, hi);
+            lo = mn;
+        } else {
+            lo = stage(lo, s, 0);
+            hi = stage(hi, s, 8);
+        }
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), lo);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes + 8), hi);
+}
+#else
+inline void sortNetwork16(int* lanes) {
+    int next[16];
+    for (int s = 0; s < BitonicNetwork16::stages; ++s) {
+        for (int i = 0; i < 16; ++i) {
+            int a = lanes[i], b = lanes[bitonic16.partner[s][i]];
+            next[i] = bitonic16.takeMax[s][i] ? max(a, b) : min(a, b);
+        }
+        memcpy(lanes, next, sizeof next);
+    }
+}
+#endif
+
+// Leaves of up to 16 ints are padded with INT_MAX and sorted by the
+// network; other types use insertion sort up to INSERTION_THRESHOLD
+template<typename T>
+constexpr size_t leafSize() {
+    return HasSortingNetwork<T>::value ? 16 : INSERTION_THRESHOLD;
+}
+
+template<typename T>
+void sortLeaf(T* first, size_t n) {
+    if constexpr (HasSortingNetwork<T>::value) {
+        int lanes[16];
+        copy(first, first + n, lanes);
+        fill(lanes + n, lanes + 16, numeric_limits<int>::max());
+        sortNetwork16(lanes);
+        copy(lanes, lanes + n, first);
+    } else {
+        insertionSort(first, first + n);
+    }
+}
+
+// Sorts src[0, n) using dst as scratch; the result ends up in dst when
+// toDst is set, otherwise in src. Ranges above 'threshold' are split
+// between the pool's threads.
+template<typename T>
+void pingPongSort(T* src, T* dst, size_t n, bool toDst, size_t threshold, ForkJoinPool& pool) {
+    if (n <= leafSize<T>()) {
+        sortLeaf(src, n);
+        if (toDst) move(src, src + n, dst);
+        return;
+    }
+    size_t half = n / 2;
+    T* from = toDst ? src : dst;
+    T* to = toDst ? dst : src;
+    // Sort both halves into the other array, then merge them back
+    if (n > threshold) {
+        pool.invoke([&] { pingPongSort(src, dst, half, !toDst, threshold, pool); },
+                    [&] { pingPongSort(src + half, dst + half, n - half, !toDst, threshold, pool); });
+        parallelMergeMove(from, half, from + half, n - half, to, threshold, pool);
+    } else {
+        pingPongSort(src, dst, half, !toDst, threshold, pool);
+        pingPongSort(src + half, dst + half, n - half, !toDst, threshold, pool);
+        mergeMove(from, half, from + half, n - half, to);
+    }
+}
+
+// Stable parallel merge sort with a single scratch allocation
+// (T must be default-constructible and movable)
+template<typename T>
+void bufferedMergeSort(vector<T>& data, ForkJoinPool& pool = defaultPool()) {
+    if (data.size() < 2) return;
+    vector<T> buffer(data.size());
+    size_t threshold = adaptiveThreshold(data.size(), sizeof(T), pool.size());
+    if (data.size() <= threshold) {
+        pingPongSort(data.data(), buffer.data(), data.size(), false, threshold, pool);
+        return;
+    }
+    pool.run([&] { pingPongSort(data.data(), buffer.data(), data.size(), false, threshold, pool); });
+}
+
+// === Radix sort ===
+// LSD radix sort for integer and floating-point keys: one stable counting
+// pass per byte of the key, alternating between the data and one scratch
+// buffer. Each pass is split into chunks on the pool: every chunk counts
+// its bytes, a prefix sum over (byte, chunk) gives each chunk its own
+// output positions, and the chunks scatter in parallel. A pass in which
+// every key has the same byte is skipped.
+
+// Maps a key to an unsigned integer of the same width with the same order
+template<typename K, typename = void>
+struct RadixKey;
+
+template<typename K>
+struct RadixKey<K, enable_if_t<is_integral<K>::value && !is_same<K, bool>::value>> {
+    using Bits = make_unsigned_t<K>;
+    static Bits encode(K key) {
+        Bits bits = Bits(key);
+        if (is_signed<K>::value) bits ^= Bits(Bits(1) << (sizeof(K) * 8 - 1));   // negatives first
+        return bits;
+    }
+};
+
+template<typename K>
+struct RadixKey<K, enable_if_t<is_floating_point<K>::value && (sizeof(K) == 4 || sizeof(K) == 8)>> {
+    using Bits = conditional_t<sizeof(K) == 4, uint32_t, uint64_t>;
+    static Bits encode(K key) {
+        // -0.0 == +0.0 and all NaNs share one encoding (a positive quiet
+        // NaN, which sorts after +inf), so equal keys keep their order
+        if (key == 0) key = 0;
+        else if (isnan(key)) key = numeric_limits<K>::quiet_NaN();
+        Bits bits;
+        memcpy(&bits, &key, sizeof bits);
+        const Bits sign = Bits(1) << (sizeof(K) * 8 - 1);
+        // Negatives: flip everything (larger magnitude sorts first);
+        // positives: set the sign bit so they follow the negatives
+        return (bits & sign) ? Bits(~bits) : Bits(bits | sign);
+    }
+};
+
+template<typename K, typename = void>
+struct IsRadixKey : false_type {};
+
+template<typename K>
+struct IsRadixKey<K, void_t<typename RadixKey<K>::Bits>> : true_type {};
+
+// Smallest chunk worth its own task in a radix pass
+const size_t RADIX_CHUNK = 1 << 16;
+
+// autoSort uses the merge sort below this many elements per key byte:
+// each radix pass has a fixed cost of 256 counters (measured crossover
+// for int: about 256 elements)
+const size_t RADIX_MIN_PER_BYTE = 64;
+
+// Runs body(i) for every i in [begin, end) on the pool
+template<typename F>
+void forkJoinFor(ForkJoinPool& pool, size_t begin, size_t end, const F& body) {
+    if (end - begin <= 1) {
+        if (begin < end) body(begin);
+        return;
+    }
+    size_t mid = begin + (end - begin) / 2;
+    pool.invoke([&] { forkJoinFor(pool, begin, mid, body); },
+                [&] { forkJoinFor(pool, mid, end, body); });
+}
+
+// Sorts records by a primitive field (stable), for example
+//   radixSortBy(people, [](const Person& p) { return p.age; });
+// (T must be default-constructible and movable)
+template<typename T, typename KeyOf>
+void radixSortBy(vector<T>& data, KeyOf keyOf, ForkJoinPool& pool = defaultPool()) {
+    using Key = decay_t<decltype(keyOf(data[0]))>;
+    static_assert(IsRadixKey<Key>::value, "radixSortBy needs an integer or floating-point key");
+    using Bits = typename RadixKey<Key>::Bits;
+
+    const size_t n = data.size();
+    if (n < 2) return;
+    const size_t chunks = max<size_t>(1, min<size_t>(pool.size(), n / RADIX_CHUNK));
+    vector<T> buffer(n);
+    vector<array<size_t, 256>> counts(chunks);
+    T* src = data.data();
+    T* dst = buffer.data();
+
+    for (size_t shift = 0; shift < sizeof(Bits) * 8; shift += 8) {
+        auto digit = [&](const T& v) { return size_t(RadixKey<Key>::encode(keyOf(v)) >> shift) & 255; };
+        forkJoinFor(pool, 0, chunks, [&](size_t c) {
+            array<size_t, 256>& count = counts[c];
+            count.fill(0);
+            for (size_t i = n * c / chunks, e = n * (c + 1) / chunks; i < e; ++i) ++count[digit(src[i])];
+        });
+
+        // Turn the counts into each chunk's first output index per byte
+        size_t offset = 0;
+        bool trivial = false;
+        for (size_t d = 0; d < 256; ++d) {
+            size_t start = offset;
+            for (size_t c = 0; c < chunks; ++c) {
+                size_t count = counts[c][d];
+                counts[c][d] = offset;
+                offset += count;
+            }
+            if (offset - start == n) trivial = true;
+        }
+        if (trivial) continue;
+
+        forkJoinFor(pool, 0, chunks, [&](size_t c) {
+            array<size_t, 256>& next = counts[c];
+            for (size_t i = n * c / chunks, e = n * (c + 1) / chunks; i < e; ++i)
+                dst[next[digit(src[i])]++] = move(src[i]);
+        });
+        swap(src, dst);
+    }
+    if (src != data.data()) data.swap(buffer);
+}
+
+template<typename T>
+void radixSort(vector<T>& data, ForkJoinPool& pool = defaultPool()) {
+    radixSortBy(data, [](const T& v) { return v; }, pool);
+}
+
+// Picks the sort for T: radix sort for integer and floating-point
+// elements (from RADIX_MIN_PER_BYTE * sizeof(T) on), bufferedMergeSort
+// otherwise
+template<typename T>
+void autoSort(vector<T>& data, ForkJoinPool& pool = defaultPool()) {
+    if constexpr (IsRadixKey<T>::value) {
+        if (data.size() >= RADIX_MIN_PER_BYTE * sizeof(T)) {
+            radixSort(data, pool);
+            return;
+        }
+    }
+    bufferedMergeSort(data, pool);
+}
+
 // Helper to run sort on full vector
 template<typename T>
 void runSequentialSort(vector<T> data) {
@@ -80,7 +681,149 @@ void runParallelSort(vector<T> data) {
          << " ms" << endl;
 }
 
-int main() {
+template<typename T>
+void runBufferedSort(vector<T> data) {
+    auto start = high_resolution_clock::now();
+    bufferedMergeSort(data);
+    auto end = high_resolution_clock::now();
+    cout << "Buffered Parallel Sort Time: "
+         << duration_cast<milliseconds>(end - start).count()
+         << " ms" << endl;
+}
+
+// === Benchmark ===
+
+// 'sort' returns a line of thread telemetry
+template<typename T, typename Sort>
+void benchmarkSort(const char* name, const vector<T>& input, const vector<T>& expected, Sort sort) {
+    vector<T> data = input;
+    allocationCount = 0;
+    countAllocations = true;
+    auto start = high_resolution_clock::now();
+    string telemetry = sort(data);
+    auto end = high_resolution_clock::now();
+    countAllocations = false;
+    size_t allocations = allocationCount;
+    cout << "  " << name << string(20 - min<size_t>(20, string(name).size()), ' ')
+         << duration_cast<milliseconds>(end - start).count() << " ms, "
+         << allocations << " allocations" << telemetry
+         << (data == expected ? "" : "  WRONG RESULT") << endl;
+}
+
+// Thread telemetry of a pool-based sort: the pool's threads are started
+// once and reused, so no thread is created during the sort
+template<typename Sort>
+string poolTelemetry(ForkJoinPool& pool, Sort sort) {
+    size_t forks = pool.forks(), steals = pool.steals();
+    sort();
+    return ", threads " + to_string(pool.size()) + " (none created), forks " +
+           to_string(pool.forks() - forks) + ", steals " + to_string(pool.steals() - steals);
+}
+
+// A record sorted by a primitive field, for radixSortBy
+struct Record {
+    double key;
+    int id;
+    bool operator<(const Record& other) const { return key < other.key; }
+    bool operator==(const Record& other) const { return key == other.key && id == other.id; }
+};
+
+// radixSortBy with both zeros and NaNs of either sign among the keys:
+// equal keys (-0.0 and +0.0 included) keep their input order as with
+// std::stable_sort, and the NaNs follow +inf, also in input order
+void runRadixSpecialKeys() {
+    const double nan = numeric_limits<double>::quiet_NaN(), inf = numeric_limits<double>::infinity();
+    vector<Record> records = {{0.0, 0}, {-0.0, 1}, {nan, 2}, {1.5, 3}, {-nan, 4},
+                              {-0.0, 5}, {inf, 6}, {-2.0, 7}, {0.0, 8}, {nan, 9}};
+    vector<Record> expected;
+    for (const Record& r : records) if (!isnan(r.key)) expected.push_back(r);
+    stable_sort(expected.begin(), expected.end());
+    for (const Record& r : records) if (isnan(r.key)) expected.push_back(r);
+
+    radixSortBy(records, [](const Record& r) { return r.key; });
+    bool same = equal(records.begin(), records.end(), expected.begin(),
+                      [](const Record& a, const Record& b) { return a.id == b.id; });
+    cout << "Radix sort keeps the order of equal zeros and NaNs: " << (same ? "yes" : "no") << endl;
+}
+
+// std::sort, asyncMergeSort (the original std::async version),
+// parallelMergeSort, bufferedMergeSort, radixSort and autoSort on 1M,
+// 10M, ... ints up to maxSize, then records sorted by a double key
+void runBenchmark(size_t maxSize, unsigned threads) {
+    ForkJoinPool pool(threads);
+    cout << "Hardware threads: " << thread::hardware_concurrency()
+         << ", pool threads: " << pool.size()
+#ifdef __AVX2__
+         << ", leaf network: AVX2" << endl;
+#else
+         << ", leaf network: scalar" << endl;
+#endif
+    mt19937 rng(42);
+    for (size_t n = 1000000; n <= maxSize; n *= 10) {
+        vector<int> input(n);
+        uniform_int_distribution<int> dist(0, INT32_MAX);
+        for (auto& val : input) val = dist(rng);
+        vector<int> expected = input;
+        sort(expected.begin(), expected.end());
+
+        cout << n << " elements (adaptive threshold "
+             << adaptiveThreshold(n, sizeof(int), pool.size()) << "):" << endl;
+        benchmarkSort("std::sort", input, expected, [](vector<int>& d) {
+            sort(d.begin(), d.end());
+            return string();
+        });
+        benchmarkSort("asyncMergeSort", input, expected, [](vector<int>& d) {
+            AsyncThreadTelemetry::started = 0;
+            AsyncThreadTelemetry::peak = 0;
+            asyncMergeSort(d, 0, d.size());
+            return ", threads created " + to_string(AsyncThreadTelemetry::started.load()) +
+                   ", at most " + to_string(AsyncThreadTelemetry::peak.load()) + " at once";
+        });
+        benchmarkSort("parallelMergeSort", input, expected, [&](vector<int>& d) {
+            return poolTelemetry(pool, [&] { parallelMergeSort(d, 0, d.size(), pool); });
+        });
+        benchmarkSort("bufferedMergeSort", input, expected, [&](vector<int>& d) {
+            return poolTelemetry(pool, [&] { bufferedMergeSort(d, pool); });
+        });
+        benchmarkSort("radixSort", input, expected, [&](vector<int>& d) {
+            return poolTelemetry(pool, [&] { radixSort(d, pool); });
+        });
+        benchmarkSort("autoSort", input, expected, [&](vector<int>& d) {
+            autoSort(d, pool);
+            return string();
+        });
+
+        vector<Record> records(n);
+        uniform_real_distribution<double> keys(-1e6, 1e6);
+        for (size_t i = 0; i < n; ++i) records[i] = {keys(rng), int(i)};
+        vector<Record> expectedRecords = records;
+        stable_sort(expectedRecords.begin(), expectedRecords.end());
+        cout << n << " records by double key:" << endl;
+        benchmarkSort("std::stable_sort", records, expectedRecords, [](vector<Record>& d) {
+            stable_sort(d.begin(), d.end());
+            return string();
+        });
+        benchmarkSort("bufferedMergeSort", records, expectedRecords, [&](vector<Record>& d) {
+            bufferedMergeSort(d, pool);
+            return string();
+        });
+        benchmarkSort("radixSortBy", records, expectedRecords, [&](vector<Record>& d) {
+            radixSortBy(d, [](const Record& r) { return r.key; }, pool);
+            return string();
+        });
+    }
+}
+
+// Run with --bench [max elements] [threads] for the benchmark
+// (default 10000000 elements on hardware_concurrency() threads)
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        size_t maxSize = argc > 2 ? strtoull(argv[2], nullptr, 10) : 10000000;
+        unsigned threads = argc > 3 ? unsigned(atoi(argv[3])) : thread::hardware_concurrency();
+        runBenchmark(maxSize, max(1u, threads));
+        return 0;
+    }
+
     const size_t DATA_SIZE = 200000;
     vector<int> data(DATA_SIZE);
 
@@ -93,6 +836,8 @@ int main() {
 
     runSequentialSort(data);
     runParallelSort(data);
+    runBufferedSort(data);
+    runRadixSpecialKeys();
 
     return 0;
 }
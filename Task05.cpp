@@ -14,49 +14,302 @@ Benchmark and compare performance against standard std::shared_ptr.*/
 #include <vector>
 #include <chrono>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <cstdint>
+#include <cassert>
+#include <functional>
+#include <utility>
+#include <iomanip>
+#include <new>
+#ifdef __linux__
+#include <pthread.h>
+#endif
 
 using namespace std;
 
-// Atomic reference-counted control block
+// === Reference counting policies ===
+// AtomicSharedPtr<T, RefCount> keeps its owner count in a RefCount. Each
+// AtomicSharedPtr also keeps a RefCount::Token: where its own reference
+// was counted, handed back to release().
+//   acquire()               counts one more owner, returns its token
+//   release(token)          true when that was the last owner
+//   acquireIfAlive(token)   acquire() unless the count already reached zero
+//   count()                 number of owners (a snapshot)
+
+// One shared counter: every copy and release is a read-modify-write on
+// the same cache line
+struct AtomicRefCount {
+    struct Token {};
+
+    atomic<size_t> refCount{1};
+
+    Token acquire() {
+        refCount.fetch_add(1, memory_order_relaxed);
+        return Token();
+    }
+
+    bool release(Token) { return refCount.fetch_sub(1, memory_order_acq_rel) == 1; }
+
+    // Never revives a count that reached zero
+    bool acquireIfAlive(Token&) {
+        size_t count = refCount.load(memory_order_relaxed);
+        while (count != 0) {
+            if (refCount.compare_exchange_weak(count, count + 1, memory_order_acq_rel, memory_order_relaxed)) return true;
+        }
+        return false;
+    }
+
+    size_t count() const { return refCount.load(); }
+};
+
+// Sharded counter for objects that many threads copy while one long-lived
+// owner (the reference the object was created with) keeps them alive.
+//
+// Copies are counted in the copying thread's shard, each on its own cache
+// line; the reference remembers the shard, so releasing it on another
+// thread stays correct. 'central' counts direct references (the first one
+// and those from acquireIfAlive) in its high half and, in its low half,
+// one token per shard in use. While a direct reference is alive, a shard
+// that drops to zero keeps its token, so copy-and-drop never touches
+// 'central'. Once the direct references are gone, idle shards hand their
+// tokens back and the object goes when 'central' reaches zero.
+//
+// Costs 16 cache lines per control block, so it is meant for a few hot
+// objects, not for everything.
+class ShardedRefCount {
+public:
+    static constexpr unsigned SHARDS = 16;
+
+    struct Token {
+        unsigned shard = DIRECT;
+    };
+
+    Token acquire() {
+        unsigned s = threadShard();
+        size_t old = shards[s].count.fetch_add(1, memory_order_relaxed);
+        // First reference in an idle shard: the shard takes a token. The
+        // reference copied from keeps 'central' above zero meanwhile.
+        if (!(old & HAS_TOKEN) && !(shards[s].count.fetch_or(HAS_TOKEN, memory_order_relaxed) & HAS_TOKEN)) {
+            central.fetch_add(1, memory_order_relaxed);
+        }
+        return Token{s};
+    }
+
+    bool release(Token token) {
+        if (token.shard == DIRECT) {
+            size_t old = central.fetch_sub(ONE_DIRECT, memory_order_seq_cst);
+            if (old == ONE_DIRECT) return true;
+            if (old / ONE_DIRECT > 1) return false;
+            // Last direct reference: no shard may keep an idle token now
+            for (unsigned s = 0; s < SHARDS; ++s) {
+                if (returnIdleToken(s)) return true;
+            }
+            return false;
+        }
+        size_t old = shards[token.shard].count.fetch_sub(1, memory_order_seq_cst);
+        if ((old & ~HAS_TOKEN) != 1) return false;
+        // Pairs with the fetch_sub above: either this thread sees the last
+        // direct reference gone, or that releaser's scan sees this shard idle
+        if (central.load(memory_order_seq_cst) >= ONE_DIRECT) return false;
+        return returnIdleToken(token.shard);
+    }
+
+    // A direct reference, unless the count already reached zero
+    bool acquireIfAlive(Token& token) {
+        size_t count = central.load(memory_order_relaxed);
+        while (count != 0) {
+            if (central.compare_exchange_weak(count, count + ONE_DIRECT, memory_order_acq_rel, memory_order_relaxed)) {
+                token.shard = DIRECT;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t count() const {
+        size_t total = central.load() / ONE_DIRECT;
+        for (const Shard& shard : shards) total += shard.count.load() & ~HAS_TOKEN;
+        return total;
+    }
+
+private:
+    static constexpr unsigned DIRECT = SHARDS;
+    static constexpr size_t ONE_DIRECT = size_t(1) << 32;
+    static constexpr size_t HAS_TOKEN = size_t(1) << 63;
+
+    struct alignas(64) Shard {
+        atomic<size_t> count{0};
+    };
+
+    // Threads take shards round-robin as they first use one
+    static unsigned threadShard() {
+        static atomic<unsigned> nextShard{0};
+        thread_local unsigned shard = nextShard.fetch_add(1, memory_order_relaxed) % SHARDS;
+        return shard;
+    }
+
+    // Takes the token back from shard s if no reference is counted there;
+    // true when that was the last thing keeping the object alive
+    bool returnIdleToken(unsigned s) {
+        size_t idle = HAS_TOKEN;
+        if (!shards[s].count.compare_exchange_strong(idle, 0, memory_order_seq_cst)) return false;
+        return central.fetch_sub(1, memory_order_acq_rel) == 1;
+    }
+
+    alignas(64) atomic<size_t> central{ONE_DIRECT};
+    Shard shards[SHARDS];
+};
+
 template<typename T>
-class AtomicSharedPtr {
+class AtomicSharedSlot;
+template<typename T, typename RefCount = AtomicRefCount>
+class AtomicWeakPtr;
+template<typename T, typename RefCount = AtomicRefCount>
+class AtomicSharedPtr;
+template<typename T, typename RefCount = AtomicRefCount, typename Alloc, typename... Args>
+AtomicSharedPtr<T, RefCount> allocate_atomic_shared(const Alloc& alloc, Args&&... args);
+
+// Atomic reference-counted control block
+template<typename T, typename RefCount>
+class AtomicSharedPtr : private RefCount::Token {
 private:
+    using Token = typename RefCount::Token;
+
+    // refs counts owners, weakCount counts weak references plus one for
+    // all the owners together: the object goes when the last owner does,
+    // the block when weakCount reaches zero
     struct ControlBlock {
         T* ptr;
-        atomic<size_t> refCount;
+        RefCount refs;
+        atomic<size_t> weakCount;
+
+        ControlBlock(T* p) : ptr(p), weakCount(1) {}
+        virtual ~ControlBlock() = default;
+
+        virtual void destroyObject() = 0;
+        // Frees the block with the allocator it came from
+        virtual void deallocate() = 0;
+
+        void releaseStrong(Token token) {
+            if (refs.release(token)) {
+                destroyObject();
+                // No weak references left: nobody else can reach the block
+                if (weakCount.load(memory_order_acquire) == 1) deallocate();
+                else releaseWeak();
+            }
+        }
+        void releaseWeak() {
+            if (weakCount.fetch_sub(1, memory_order_acq_rel) == 1) deallocate();
+        }
+    };
+
+    // Block for an object the caller allocated: AtomicSharedPtr(new T)
+    template<typename Deleter, typename Alloc>
+    struct PointerBlock : ControlBlock {
+        Deleter deleter;
+        Alloc alloc;
 
-        ControlBlock(T* p) : ptr(p), refCount(1) {}
-        ~ControlBlock() { delete ptr; }
+        PointerBlock(T* p, const Deleter& d, const Alloc& a) : ControlBlock(p), deleter(d), alloc(a) {}
+        void destroyObject() override { deleter(this->ptr); }
+        void deallocate() override { destroyBlock(this); }
     };
 
+    // Block with the object stored in it: make_atomic_shared, one allocation
+    template<typename Alloc>
+    struct InlineBlock : ControlBlock {
+        Alloc alloc;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        explicit InlineBlock(const Alloc& a) : ControlBlock(nullptr), alloc(a) {}
+        void destroyObject() override { allocator_traits<Alloc>::destroy(alloc, this->ptr); }
+        void deallocate() override { destroyBlock(this); }
+    };
+
+    template<typename Block, typename Alloc, typename... Args>
+    static Block* createBlock(const Alloc& alloc, Args&&... args) {
+        using BlockAlloc = typename allocator_traits<Alloc>::template rebind_alloc<Block>;
+        BlockAlloc blockAlloc(alloc);
+        Block* b = allocator_traits<BlockAlloc>::allocate(blockAlloc, 1);
+        try {
+            allocator_traits<BlockAlloc>::construct(blockAlloc, b, std::forward<Args>(args)...);
+        } catch (...) {
+            allocator_traits<BlockAlloc>::deallocate(blockAlloc, b, 1);
+            throw;
+        }
+        return b;
+    }
+
+    template<typename Block>
+    static void destroyBlock(Block* b) {
+        using BlockAlloc = typename allocator_traits<decltype(b->alloc)>::template rebind_alloc<Block>;
+        BlockAlloc blockAlloc(b->alloc);
+        allocator_traits<BlockAlloc>::destroy(blockAlloc, b);
+        allocator_traits<BlockAlloc>::deallocate(blockAlloc, b, 1);
+    }
+
     ControlBlock* block;
 
+    // Where this reference is counted; empty for AtomicRefCount
+    Token& token() { return *this; }
+    const Token& token() const { return *this; }
+
+    // The slot moves references in and out of AtomicSharedPtr directly
+    friend class AtomicSharedSlot<T>;
+    friend class AtomicWeakPtr<T, RefCount>;
+    template<typename U, typename R, typename Alloc, typename... Args>
+    friend AtomicSharedPtr<U, R> allocate_atomic_shared(const Alloc& alloc, Args&&... args);
+
 public:
     AtomicSharedPtr() : block(nullptr) {}
 
-    explicit AtomicSharedPtr(T* ptr) {
-        block = new ControlBlock(ptr);
+    explicit AtomicSharedPtr(T* ptr) : AtomicSharedPtr(ptr, default_delete<T>()) {}
+
+    // deleter(ptr) runs when the last owner goes
+    template<typename Deleter>
+    AtomicSharedPtr(T* ptr, Deleter deleter) : AtomicSharedPtr(ptr, move(deleter), allocator<T>()) {}
+
+    // The control block is allocated with alloc
+    template<typename Deleter, typename Alloc>
+    AtomicSharedPtr(T* ptr, Deleter deleter, const Alloc& alloc) : block(nullptr) {
+        try {
+            block = createBlock<PointerBlock<Deleter, Alloc>>(alloc, ptr, deleter, alloc);
+        } catch (...) {
+            deleter(ptr);
+            throw;
+        }
     }
 
     // Copy constructor
     AtomicSharedPtr(const AtomicSharedPtr& other) {
         block = other.block;
         if (block) {
-            block->refCount.fetch_add(1, memory_order_relaxed);
+            token() = block->refs.acquire();
         }
     }
 
-    // Copy assignment
+    // Move constructor: hands the reference over without touching the count
+    AtomicSharedPtr(AtomicSharedPtr&& other) noexcept
+        : Token(other.token()), block(std::exchange(other.block, nullptr)) {}
+
+    // Assignments take the new reference before dropping the old one:
+    // 'other' may live inside the object the old reference keeps alive,
+    // as in p = move(p->next)
     AtomicSharedPtr& operator=(const AtomicSharedPtr& other) {
-        if (this == &other) return *this;
-        release();
-        block = other.block;
-        if (block) {
-            block->refCount.fetch_add(1, memory_order_relaxed);
-        }
+        AtomicSharedPtr(other).swap(*this);
+        return *this;
+    }
+
+    AtomicSharedPtr& operator=(AtomicSharedPtr&& other) noexcept {
+        AtomicSharedPtr(std::move(other)).swap(*this);
         return *this;
     }
 
+    void swap(AtomicSharedPtr& other) noexcept {
+        std::swap(token(), other.token());
+        std::swap(block, other.block);
+    }
+
     // Destructor
     ~AtomicSharedPtr() {
         release();
@@ -67,20 +320,233 @@ public:
     bool isValid() const { return block != nullptr; }
 
     size_t use_count() const {
-        return block ? block->refCount.load() : 0;
+        return block ? block->refs.count() : 0;
     }
 
 private:
     void release() {
         if (block) {
-            if (block->refCount.fetch_sub(1, memory_order_acq_rel) == 1) {
-                delete block;
-            }
+            block->releaseStrong(token());
             block = nullptr;
         }
     }
 };
 
+// Object and control block in one allocation from alloc
+template<typename T, typename RefCount, typename Alloc, typename... Args>
+AtomicSharedPtr<T, RefCount> allocate_atomic_shared(const Alloc& alloc, Args&&... args) {
+    using Ptr = AtomicSharedPtr<T, RefCount>;
+    using ObjectAlloc = typename allocator_traits<Alloc>::template rebind_alloc<T>;
+    using Block = typename Ptr::template InlineBlock<ObjectAlloc>;
+    Block* b = Ptr::template createBlock<Block>(alloc, ObjectAlloc(alloc));
+    T* object = reinterpret_cast<T*>(b->storage);
+    try {
+        allocator_traits<ObjectAlloc>::construct(b->alloc, object, std::forward<Args>(args)...);
+    } catch (...) {
+        Ptr::destroyBlock(b);
+        throw;
+    }
+    b->ptr = object;
+    Ptr p;
+    p.block = b;
+    return p;
+}
+
+template<typename T, typename RefCount = AtomicRefCount, typename... Args>
+AtomicSharedPtr<T, RefCount> make_atomic_shared(Args&&... args) {
+    return allocate_atomic_shared<T, RefCount>(allocator<T>(), std::forward<Args>(args)...);
+}
+
+// Non-owning reference: lock() gives an owner while the object is alive.
+// The control block stays until the last weak reference is gone.
+template<typename T, typename RefCount>
+class AtomicWeakPtr {
+    using ControlBlock = typename AtomicSharedPtr<T, RefCount>::ControlBlock;
+
+public:
+    AtomicWeakPtr() : block(nullptr) {}
+
+    AtomicWeakPtr(const AtomicSharedPtr<T, RefCount>& owner) : block(owner.block) { acquire(); }
+    AtomicWeakPtr(const AtomicWeakPtr& other) : block(other.block) { acquire(); }
+    AtomicWeakPtr(AtomicWeakPtr&& other) noexcept : block(std::exchange(other.block, nullptr)) {}
+
+    // New reference first, as in AtomicSharedPtr
+    AtomicWeakPtr& operator=(const AtomicWeakPtr& other) {
+        AtomicWeakPtr copy(other);
+        std::swap(block, copy.block);
+        return *this;
+    }
+
+    AtomicWeakPtr& operator=(AtomicWeakPtr&& other) noexcept {
+        AtomicWeakPtr taken(std::move(other));
+        std::swap(block, taken.block);
+        return *this;
+    }
+
+    ~AtomicWeakPtr() { release(); }
+
+    // An owner, or an empty pointer once the object is destroyed. Never
+    // revives a count that reached zero.
+    AtomicSharedPtr<T, RefCount> lock() const {
+        AtomicSharedPtr<T, RefCount> p;
+        if (block && block->refs.acquireIfAlive(p.token())) p.block = block;
+        return p;
+    }
+
+    bool expired() const { return use_count() == 0; }
+
+    size_t use_count() const {
+        return block ? block->refs.count() : 0;
+    }
+
+private:
+    void acquire() {
+        if (block) block->weakCount.fetch_add(1, memory_order_relaxed);
+    }
+
+    void release() {
+        if (block) {
+            block->releaseWeak();
+            block = nullptr;
+        }
+    }
+
+    ControlBlock* block;
+};
+
+// Atomic slot holding an AtomicSharedPtr: load, store, exchange and
+// compare_exchange may run concurrently from any thread, without locks.
+// Copying one AtomicSharedPtr while another thread assigns to it is a data
+// race; a slot is the shared place to publish a pointer (a config, a
+// routing table) that readers pick up.
+//
+// Split reference count: the 64-bit word packs the block pointer (low 48
+// bits) with a local count (high 16 bits). A reader first takes a ticket
+// with one fetch_add on the word, which keeps the block alive without
+// touching it, then adds its own reference to the block and hands the
+// ticket back with a CAS on the word. A writer takes a ticket too, adds a
+// bias to the old block's refCount and only then swaps the word; readers
+// that find their block gone return the ticket to refCount, which the bias
+// keeps above zero until the writer turns the tickets still out into
+// references. No reader waits for a writer, and no block is freed while a
+// ticket for it is out.
+template<typename T>
+class AtomicSharedSlot {
+    using ControlBlock = typename AtomicSharedPtr<T>::ControlBlock;
+
+public:
+    AtomicSharedSlot() : word(0) {}
+    explicit AtomicSharedSlot(AtomicSharedPtr<T> value) : word(pack(take(value), 0)) {}
+
+    AtomicSharedSlot(const AtomicSharedSlot&) = delete;
+    AtomicSharedSlot& operator=(const AtomicSharedSlot&) = delete;
+
+    ~AtomicSharedSlot() { adopt(blockOf(word.load(memory_order_acquire))); }
+
+    AtomicSharedPtr<T> load() const {
+        uint64_t current = word.load(memory_order_acquire);
+        if (!blockOf(current)) return AtomicSharedPtr<T>();
+
+        ControlBlock* block = blockOf(word.fetch_add(ONE_TICKET, memory_order_acq_rel));
+        if (block) block->refs.refCount.fetch_add(1, memory_order_relaxed);
+        returnTicket(block);
+        return adopt(block);
+    }
+
+    void store(AtomicSharedPtr<T> value) { exchange(move(value)); }
+
+    AtomicSharedPtr<T> exchange(AtomicSharedPtr<T> value) {
+        ControlBlock* old = nullptr;
+        replace(take(value), nullptr, true, old);
+        return adopt(old);
+    }
+
+    // Replaces the value with 'desired' if it still points to the same
+    // object as 'expected'; otherwise loads the current value into
+    // 'expected'. Tickets taken by readers do not make it fail.
+    bool compare_exchange(AtomicSharedPtr<T>& expected, AtomicSharedPtr<T> desired) {
+        ControlBlock* old = nullptr;
+        if (replace(desired.block, expected.block, false, old)) {
+            take(desired);              // the slot owns that reference now
+            adopt(old);
+            return true;
+        }
+        expected = load();
+        return false;
+    }
+
+    static constexpr bool is_always_lock_free = atomic<uint64_t>::is_always_lock_free;
+
+private:
+    // Blocks must have addresses below 2^48. Linux keeps user space there by
+    // default, but not for every process: mappings above 2^47 with 5-level
+    // paging (LA57) or 52-bit AArch64 addresses, and tagged pointers (AArch64
+    // TBI / MTE), use the high bits. pack() checks this in debug builds.
+    static_assert(sizeof(void*) == 8, "AtomicSharedSlot packs a 48-bit pointer into 64 bits");
+
+    static constexpr uint64_t POINTER_MASK = (uint64_t(1) << 48) - 1;
+    static constexpr uint64_t ONE_TICKET = uint64_t(1) << 48;
+    // More than the 16-bit ticket count can ever hold
+    static constexpr size_t TICKET_BIAS = size_t(1) << 16;
+
+    static uint64_t pack(ControlBlock* block, uint64_t tickets) {
+        assert((reinterpret_cast<uintptr_t>(block) & ~POINTER_MASK) == 0);
+        return reinterpret_cast<uintptr_t>(block) | (tickets << 48);
+    }
+    static ControlBlock* blockOf(uint64_t w) { return reinterpret_cast<ControlBlock*>(w & POINTER_MASK); }
+    static uint64_t ticketsOf(uint64_t w) { return w >> 48; }
+
+    // Takes the reference held by p
+    static ControlBlock* take(AtomicSharedPtr<T>& p) { return std::exchange(p.block, nullptr); }
+
+    static AtomicSharedPtr<T> adopt(ControlBlock* block) {
+        AtomicSharedPtr<T> p;
+        p.block = block;
+        return p;
+    }
+
+    // Swaps 'desired' in if the slot holds 'expected' (or anything when
+    // 'any' is set) and hands the slot's old reference out in 'old'. The
+    // writer's ticket keeps the old block alive while it is biased.
+    bool replace(ControlBlock* desired, ControlBlock* expected, bool any, ControlBlock*& old) {
+        for (;;) {
+            uint64_t current = word.fetch_add(ONE_TICKET, memory_order_acq_rel) + ONE_TICKET;
+            ControlBlock* block = blockOf(current);
+            if (!any && block != expected) {
+                returnTicket(block);
+                return false;
+            }
+            if (block) block->refs.refCount.fetch_add(TICKET_BIAS, memory_order_relaxed);
+
+            while (blockOf(current) == block) {
+                if (word.compare_exchange_weak(current, pack(desired, 0), memory_order_acq_rel)) {
+                    // Readers' tickets become references; ours carried none
+                    if (block) block->refs.refCount.fetch_sub(TICKET_BIAS - (ticketsOf(current) - 1), memory_order_acq_rel);
+                    old = block;
+                    return true;
+                }
+            }
+
+            // Another writer got there first and settled our ticket
+            if (block) block->refs.refCount.fetch_sub(TICKET_BIAS, memory_order_relaxed);
+            returnTicket(block);
+        }
+    }
+
+    // Hands back a ticket taken on 'block': on the word while the block is
+    // still there, otherwise to the block's refCount where the writer that
+    // swapped it out put it
+    void returnTicket(ControlBlock* block) const {
+        uint64_t current = word.load(memory_order_acquire);
+        while (blockOf(current) == block && ticketsOf(current) > 0) {
+            if (word.compare_exchange_weak(current, current - ONE_TICKET, memory_order_acq_rel)) return;
+        }
+        if (block) block->releaseStrong({});
+    }
+
+    mutable atomic<uint64_t> word;
+};
+
 // Simple class to track object usage
 struct TestData {
     int value = 0;
@@ -89,11 +555,12 @@ struct TestData {
 };
 
 // Stress test with multiple threads
-void stressTestAtomicSharedPtr() {
+template<typename RefCount = AtomicRefCount>
+void stressTestAtomicSharedPtr(const string& label = "AtomicSharedPtr") {
     const int THREADS = 10;
     const int ITERATIONS = 100000;
 
-    AtomicSharedPtr<TestData> shared(new TestData(42));
+    AtomicSharedPtr<TestData, RefCount> shared(new TestData(42));
 
     auto start = chrono::high_resolution_clock::now();
 
@@ -101,7 +568,7 @@ void stressTestAtomicSharedPtr() {
     for (int i = 0; i < THREADS; ++i) {
         workers.emplace_back([&]() {
             for (int j = 0; j < ITERATIONS; ++j) {
-                AtomicSharedPtr<TestData> copy = shared;
+                AtomicSharedPtr<TestData, RefCount> copy = shared;
                 if (copy.isValid()) {
                     copy->doWork();
                 }
@@ -112,9 +579,9 @@ void stressTestAtomicSharedPtr() {
     for (auto& t : workers) t.join();
 
     auto end = chrono::high_resolution_clock::now();
-    cout << "[AtomicSharedPtr] Final value: " << (*shared).value << endl;
-    cout << "[AtomicSharedPtr] Ref count: " << shared.use_count() << endl;
-    cout << "[AtomicSharedPtr] Time: " << chrono::duration_cast<chrono::milliseconds>(end - start).count() << " ms" << endl;
+    cout << "[" << label << "] Final value: " << (*shared).value << endl;
+    cout << "[" << label << "] Ref count: " << shared.use_count() << endl;
+    cout << "[" << label << "] Time: " << chrono::duration_cast<chrono::milliseconds>(end - start).count() << " ms" << endl;
 }
 
 // Optional: Compare with std::shared_ptr
@@ -146,13 +613,560 @@ void stressTestStdSharedPtr() {
     cout << "[std::shared_ptr] Time: " << chrono::duration_cast<chrono::milliseconds>(end - start).count() << " ms" << endl;
 }
 
-int main() {
+// Snapshot published through a slot; the checksum lets readers detect an
+// object that is torn or already freed
+struct Config {
+    static atomic<int> alive;
+    long version;
+    long checksum;
+    explicit Config(long v) : version(v), checksum(v * 31 + 7) { alive.fetch_add(1); }
+    ~Config() {
+        checksum = -1;
+        alive.fetch_sub(1);
+    }
+};
+atomic<int> Config::alive{0};
+
+// Sharded counts with references that move between threads: copies are
+// dropped on other threads than the ones that made them, and the creating
+// reference goes while the workers still copy. The config must be freed
+// exactly once, after the last copy.
+void testShardedRefCount() {
+    using Ptr = AtomicSharedPtr<Config, ShardedRefCount>;
+    const int THREADS = 8;
+    const int ITERATIONS = 100000;
+
+    atomic<long> torn{0};
+    int aliveBefore = Config::alive;
+    AtomicWeakPtr<Config, ShardedRefCount> watcher;
+    {
+        Ptr root = make_atomic_shared<Config, ShardedRefCount>(1);
+        watcher = AtomicWeakPtr<Config, ShardedRefCount>(root);
+        // Counted in this thread's shard, released by the workers
+        vector<Ptr> start(THREADS, root);
+        vector<Ptr> mailbox(THREADS);
+        vector<mutex> mailboxLocks(THREADS);
+
+        vector<thread> workers;
+        for (int i = 0; i < THREADS; ++i) {
+            workers.emplace_back([&, i]() {
+                Ptr mine = move(start[i]);
+                for (int j = 0; j < ITERATIONS; ++j) {
+                    Ptr copy = mine;
+                    if (copy->checksum != copy->version * 31 + 7) torn.fetch_add(1);
+                    if (j % 64 == 0) {
+                        // Hand a copy to the next thread and take whatever is waiting
+                        int next = (i + 1) % THREADS;
+                        {
+                            lock_guard<mutex> lock(mailboxLocks[next]);
+                            mailbox[next] = copy;
+                        }
+                        lock_guard<mutex> lock(mailboxLocks[i]);
+                        if (mailbox[i].isValid()) mine = move(mailbox[i]);
+                    }
+                    if (j % 1024 == 0) {
+                        Ptr locked = watcher.lock();
+                        if (!locked.isValid() || locked->checksum != locked->version * 31 + 7) torn.fetch_add(1);
+                    }
+                }
+            });
+        }
+        root = Ptr();
+        for (auto& t : workers) t.join();
+        cout << "[Sharded] Torn reads: " << torn.load() << endl;
+        cout << "[Sharded] Owners left in mailboxes: " << watcher.use_count() << endl;
+    }
+    cout << "[Sharded] Expired after the last owner: " << (watcher.expired() ? "yes" : "no") << endl;
+    cout << "[Sharded] Configs leaked: " << Config::alive - aliveBefore << endl;
+}
+
+// Allocator that counts the blocks it hands out, to check the control
+// block comes from it
+template<typename T>
+struct CountingAllocator {
+    using value_type = T;
+    atomic<int>* live;
+
+    explicit CountingAllocator(atomic<int>* l) : live(l) {}
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U>& other) : live(other.live) {}
+
+    T* allocate(size_t n) {
+        live->fetch_add(1);
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t) {
+        live->fetch_sub(1);
+        ::operator delete(p);
+    }
+    template<typename U>
+    bool operator==(const CountingAllocator<U>& other) const { return live == other.live; }
+    template<typename U>
+    bool operator!=(const CountingAllocator<U>& other) const { return live != other.live; }
+};
+
+// make_atomic_shared, moves, custom deleters and allocators, and weak
+// references that lock() while other threads drop the last owners
+void testOwnership() {
+    AtomicSharedPtr<TestData> made = make_atomic_shared<TestData>(7);
+    AtomicSharedPtr<TestData> moved = move(made);
+    cout << "[Ownership] make_atomic_shared value: " << moved->value
+         << ", use count after move: " << moved.use_count()
+         << ", moved-from valid: " << (made.isValid() ? "yes" : "no") << endl;
+
+    int deleted = 0;
+    {
+        AtomicSharedPtr<TestData> custom(new TestData(1), [&deleted](TestData* p) {
+            ++deleted;
+            delete p;
+        });
+        AtomicSharedPtr<TestData> copy = custom;
+    }
+    cout << "[Ownership] Custom deleter calls: " << deleted << endl;
+
+    atomic<int> blocks{0};
+    {
+        CountingAllocator<TestData> alloc(&blocks);
+        AtomicSharedPtr<TestData> a(new TestData(2), default_delete<TestData>(), alloc);
+        AtomicSharedPtr<TestData> b = allocate_atomic_shared<TestData>(alloc, 3);
+        cout << "[Ownership] Blocks from allocator: " << blocks.load() << endl;
+    }
+    cout << "[Ownership] Blocks after release: " << blocks.load() << endl;
+
+    AtomicWeakPtr<TestData> weak(moved);
+    AtomicSharedPtr<TestData> locked = weak.lock();
+    cout << "[Ownership] Weak lock while owned: " << (locked.isValid() ? "valid" : "empty") << endl;
+    locked = AtomicSharedPtr<TestData>();
+    moved = AtomicSharedPtr<TestData>();
+    cout << "[Ownership] Weak lock after release: " << (weak.lock().isValid() ? "valid" : "empty")
+         << ", expired: " << (weak.expired() ? "yes" : "no") << endl;
+
+    // Walking a list by assigning a pointer from inside the node it owns:
+    // the assignment must take the next node before dropping this one
+    {
+        struct Node {
+            int value;
+            AtomicSharedPtr<Node> next;
+        };
+        AtomicSharedPtr<Node> head;
+        for (int i = 3; i >= 1; --i) {
+            AtomicSharedPtr<Node> node = make_atomic_shared<Node>();
+            node->value = i;
+            node->next = move(head);
+            head = move(node);
+        }
+        int sum = 0;
+        for (AtomicSharedPtr<Node> p = head; p.isValid(); p = move(p->next)) sum += p->value;
+        head = AtomicSharedPtr<Node>();
+        AtomicSharedPtr<Node> self = make_atomic_shared<Node>();
+        self = self;
+        AtomicSharedPtr<Node>& alias = self;
+        self = move(alias);
+        cout << "[Ownership] List walk with p = move(p->next): sum " << sum
+             << ", self-assignment keeps owner: " << (self.isValid() && self.use_count() == 1 ? "yes" : "no") << endl;
+    }
+
+    // Each thread drops its owner halfway through; every lock() must give
+    // an intact config or nothing
+    const int THREADS = 8;
+    const int ITERATIONS = 100000;
+    atomic<long> torn{0};
+    atomic<long> emptyLocks{0};
+    {
+        atomic<int> configBlocks{0};
+        AtomicWeakPtr<Config> watcher;
+        {
+            AtomicSharedPtr<Config> owner = allocate_atomic_shared<Config>(CountingAllocator<Config>(&configBlocks), 1);
+            watcher = AtomicWeakPtr<Config>(owner);
+            vector<AtomicSharedPtr<Config>> owners(THREADS, owner);
+            owner = AtomicSharedPtr<Config>();
+
+            vector<thread> workers;
+            for (int i = 0; i < THREADS; ++i) {
+                workers.emplace_back([&, i]() {
+                    AtomicSharedPtr<Config> mine = move(owners[i]);
+                    AtomicWeakPtr<Config> weakCopy = watcher;
+                    for (int j = 0; j < ITERATIONS; ++j) {
+                        if (j == ITERATIONS / 2) mine = AtomicSharedPtr<Config>();
+                        AtomicSharedPtr<Config> config = weakCopy.lock();
+                        if (!config.isValid()) emptyLocks.fetch_add(1);
+                        else if (config->checksum != config->version * 31 + 7) torn.fetch_add(1);
+                    }
+                });
+            }
+            for (auto& t : workers) t.join();
+        }
+        cout << "[Ownership] Concurrent weak locks: " << torn.load() << " torn, "
+             << (watcher.expired() ? "expired" : "still owned") << ", "
+             << (emptyLocks.load() > 0 ? "some empty" : "none empty") << endl;
+        watcher = AtomicWeakPtr<Config>();
+        cout << "[Ownership] Config blocks left: " << configBlocks.load() << endl;
+    }
+}
+
+// Readers load while writers store, exchange and compare_exchange new
+// configs: every config read must be intact, and none may leak
+void stressTestAtomicSharedSlot() {
+    const int READERS = 8;
+    const int WRITERS = 2;
+    const int ITERATIONS = 200000;
+
+    atomic<long> torn{0};
+    auto start = chrono::high_resolution_clock::now();
+    {
+        AtomicSharedSlot<Config> slot(AtomicSharedPtr<Config>(new Config(0)));
+        atomic<long> nextVersion{1};
+        vector<thread> workers;
+        for (int i = 0; i < READERS; ++i) {
+            workers.emplace_back([&]() {
+                for (int j = 0; j < ITERATIONS; ++j) {
+                    AtomicSharedPtr<Config> config = slot.load();
+                    if (!config.isValid() || config->checksum != config->version * 31 + 7) torn.fetch_add(1);
+                }
+            });
+        }
+        for (int i = 0; i < WRITERS; ++i) {
+            workers.emplace_back([&]() {
+                for (int j = 0; j < ITERATIONS / 10; ++j) {
+                    AtomicSharedPtr<Config> next(new Config(nextVersion.fetch_add(1)));
+                    if (j % 3 == 0) {
+                        slot.store(next);
+                    } else if (j % 3 == 1) {
+                        AtomicSharedPtr<Config> old = slot.exchange(next);
+                        if (!old.isValid() || old->checksum != old->version * 31 + 7) torn.fetch_add(1);
+                    } else {
+                        AtomicSharedPtr<Config> expected = slot.load();
+                        while (!slot.compare_exchange(expected, next)) {}
+                    }
+                }
+            });
+        }
+        for (auto& t : workers) t.join();
+    }
+    auto end = chrono::high_resolution_clock::now();
+    cout << "[AtomicSharedSlot] Torn reads: " << torn.load() << endl;
+    cout << "[AtomicSharedSlot] Configs leaked: " << Config::alive.load() << endl;
+    cout << "[AtomicSharedSlot] Time: " << chrono::duration_cast<chrono::milliseconds>(end - start).count() << " ms" << endl;
+}
+
+// === Ownership benchmark ===
+
+atomic<long> benchSink{0};
+
+// Allocations and bytes handed out by TallyAllocator (single thread only)
+size_t tallyAllocations = 0;
+size_t tallyBytes = 0;
+
+// Stateless allocator that tallies what it hands out, so the object and
+// control blocks of each benchmark row are counted without taking up room
+// in the control block
+template<typename T>
+struct TallyAllocator {
+    using value_type = T;
+
+    TallyAllocator() = default;
+    template<typename U>
+    TallyAllocator(const TallyAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        ++tallyAllocations;
+        tallyBytes += n * sizeof(T);
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t) { ::operator delete(p); }
+    template<typename U>
+    bool operator==(const TallyAllocator<U>&) const { return true; }
+    template<typename U>
+    bool operator!=(const TallyAllocator<U>&) const { return false; }
+};
+
+// 'new T(args...)' through TallyAllocator, and the deleter that undoes it
+template<typename T, typename... Args>
+T* tallyNew(Args&&... args) {
+    return new (TallyAllocator<T>().allocate(1)) T(std::forward<Args>(args)...);
+}
+template<typename T>
+struct TallyDelete {
+    void operator()(T* p) const {
+        p->~T();
+        TallyAllocator<T>().deallocate(p, 1);
+    }
+};
+
+// Creates and drops 'count' objects through 'make'
+template<typename Make>
+void benchmarkCreate(const char* name, Make make) {
+    const int COUNT = 1000000;
+    tallyAllocations = 0;
+    tallyBytes = 0;
+    auto start = chrono::high_resolution_clock::now();
+    long sum = 0;
+    for (int i = 0; i < COUNT; ++i) sum += make(i)->value;
+    auto end = chrono::high_resolution_clock::now();
+    benchSink.fetch_add(sum, memory_order_relaxed);
+    cout << "  " << left << setw(26) << name << right << setw(8)
+         << chrono::duration<double, nano>(end - start).count() / COUNT << " ns"
+         << setw(8) << double(tallyAllocations) / COUNT << " allocs"
+         << setw(8) << tallyBytes / COUNT << " bytes" << endl;
+}
+
+// Copies and moves of one owner, 'count' times each
+template<typename Ptr>
+void benchmarkHandOff(const char* name, Ptr owner) {
+    const int COUNT = 10000000;
+    auto start = chrono::high_resolution_clock::now();
+    long sum = 0;
+    for (int i = 0; i < COUNT; ++i) {
+        Ptr copy = owner;
+        sum += copy->value;
+    }
+    auto middle = chrono::high_resolution_clock::now();
+    vector<Ptr> ring(64);
+    ring[0] = owner;
+    for (int i = 0; i < COUNT; ++i) {
+        Ptr& next = ring[(i + 1) % ring.size()];
+        next = move(ring[i % ring.size()]);
+        sum += next->value;
+    }
+    auto end = chrono::high_resolution_clock::now();
+    benchSink.fetch_add(sum, memory_order_relaxed);
+    cout << "  " << left << setw(26) << name << right
+         << setw(8) << chrono::duration<double, nano>(middle - start).count() / COUNT << " ns/copy"
+         << setw(8) << chrono::duration<double, nano>(end - middle).count() / COUNT << " ns/move" << endl;
+}
+
+void benchmarkOwnership() {
+    // libstdc++ counts non-atomically until the first thread starts
+    thread([]() {}).join();
+    cout << fixed << setprecision(2);
+    cout << "Create and drop one TestData:" << endl;
+    TallyAllocator<TestData> alloc;
+    benchmarkCreate("AtomicSharedPtr(new T)", [&](int i) {
+        return AtomicSharedPtr<TestData>(tallyNew<TestData>(i), TallyDelete<TestData>(), alloc);
+    });
+    benchmarkCreate("allocate_atomic_shared", [&](int i) { return allocate_atomic_shared<TestData>(alloc, i); });
+    benchmarkCreate("shared_ptr(new T)", [&](int i) {
+        return shared_ptr<TestData>(tallyNew<TestData>(i), TallyDelete<TestData>(), alloc);
+    });
+    benchmarkCreate("allocate_shared", [&](int i) { return allocate_shared<TestData>(alloc, i); });
+    cout << "Hand-off of one owner (single thread):" << endl;
+    benchmarkHandOff("AtomicSharedPtr", make_atomic_shared<TestData>(1));
+    benchmarkHandOff("shared_ptr", make_shared<TestData>(1));
+}
+
+// === Reference counting benchmark ===
+// Threads access one object that main keeps alive, either copying the
+// pointer on every access (copy-heavy) or reading through a pointer they
+// hold and copying once every 16 accesses (read-heavy).
+
+// Pins the calling thread: packed fills the first half of the CPU
+// numbering, spread alternates between the halves, which on two-socket
+// Linux machines are usually the two NUMA nodes
+void pinThread(int index, bool spread) {
+#ifdef __linux__
+    unsigned cpus = thread::hardware_concurrency();
+    if (cpus < 2) return;
+    unsigned half = cpus / 2;
+    unsigned cpu = spread ? (index % 2) * half + (index / 2) % half : index % half;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)index;
+    (void)spread;
+#endif
+}
+
+// Accesses per second over all threads
+template<typename Ptr>
+double measureRefCounting(const Ptr& root, int threads, bool spread, int accessesPerCopy) {
+    atomic<bool> stop{false};
+    atomic<long> accesses{0};
+    vector<thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&, i]() {
+            pinThread(i, spread);
+            Ptr held = root;
+            long count = 0, sum = 0;
+            while (!stop.load(memory_order_relaxed)) {
+                for (int j = 0; j < 64; ++j, ++count) {
+                    if (count % accessesPerCopy == 0) {
+                        Ptr copy = root;
+                        sum += copy->value;
+                    } else {
+                        sum += held->value;
+                    }
+                }
+            }
+            accesses.fetch_add(count);
+            benchSink.fetch_add(sum, memory_order_relaxed);
+        });
+    }
+    auto start = chrono::high_resolution_clock::now();
+    this_thread::sleep_for(chrono::milliseconds(100));
+    stop = true;
+    for (auto& t : workers) t.join();
+    double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+    return accesses.load() / seconds;
+}
+
+void benchmarkRefCounting() {
+    AtomicSharedPtr<TestData> atomicRoot = make_atomic_shared<TestData>(1);
+    AtomicSharedPtr<TestData, ShardedRefCount> shardedRoot = make_atomic_shared<TestData, ShardedRefCount>(1);
+    shared_ptr<TestData> stdRoot = make_shared<TestData>(1);
+
+    cout << "Reference counting: million accesses/s over all threads ("
+         << thread::hardware_concurrency() << " hardware threads)" << endl << fixed << setprecision(2);
+    for (int accessesPerCopy : {1, 16}) {
+        for (bool spread : {false, true}) {
+            cout << (accessesPerCopy == 1 ? "copy-heavy" : "read-heavy") << ", "
+                 << (spread ? "spread" : "packed") << ":" << endl;
+            cout << setw(8) << "threads" << setw(12) << "atomic" << setw(12) << "sharded" << setw(12) << "shared_ptr" << endl;
+            for (int threads = 1; threads <= 16; threads *= 2) {
+                cout << setw(8) << threads
+                     << setw(12) << measureRefCounting(atomicRoot, threads, spread, accessesPerCopy) / 1e6
+                     << setw(12) << measureRefCounting(shardedRoot, threads, spread, accessesPerCopy) / 1e6
+                     << setw(12) << measureRefCounting(stdRoot, threads, spread, accessesPerCopy) / 1e6 << endl;
+            }
+        }
+    }
+}
+
+// === Read-mostly benchmark ===
+// Readers keep loading the current config while one writer publishes a new
+// one every 100 us. Each variant has read() and publish(version).
+struct SlotReads {
+    AtomicSharedSlot<Config> slot{AtomicSharedPtr<Config>(new Config(0))};
+    long read() const { return slot.load()->version; }
+    void publish(long v) { slot.store(AtomicSharedPtr<Config>(new Config(v))); }
+};
+
+struct MutexReads {
+    mutable mutex m;
+    shared_ptr<Config> current = make_shared<Config>(0);
+    long read() const {
+        shared_ptr<Config> config;
+        {
+            lock_guard<mutex> lock(m);
+            config = current;
+        }
+        return config->version;
+    }
+    void publish(long v) {
+        shared_ptr<Config> next = make_shared<Config>(v);
+        lock_guard<mutex> lock(m);
+        current.swap(next);
+    }
+};
+
+#if __cplusplus < 202002L
+// std::atomic_load / atomic_store on a shared_ptr (deprecated in C++20)
+struct AtomicFunctionReads {
+    shared_ptr<Config> current = make_shared<Config>(0);
+    long read() const { return atomic_load(&current)->version; }
+    void publish(long v) { atomic_store(&current, make_shared<Config>(v)); }
+};
+#endif
+
+#ifdef __cpp_lib_atomic_shared_ptr
+struct StdAtomicReads {
+    atomic<shared_ptr<Config>> current{make_shared<Config>(0)};
+    long read() const { return current.load()->version; }
+    void publish(long v) { current.store(make_shared<Config>(v)); }
+};
+#endif
+
+// Loads per second over all readers
+template<typename Reads>
+double measureReads(int readers) {
+    Reads target;
+    atomic<bool> stop{false};
+    atomic<long> loads{0};
+    vector<thread> threads;
+    for (int i = 0; i < readers; ++i) {
+        threads.emplace_back([&]() {
+            long count = 0, sum = 0;
+            while (!stop.load(memory_order_relaxed)) {
+                sum += target.read();
+                ++count;
+            }
+            loads.fetch_add(count);
+            benchSink.fetch_add(sum, memory_order_relaxed);
+        });
+    }
+    thread writer([&]() {
+        for (long v = 1; !stop.load(memory_order_relaxed); ++v) {
+            target.publish(v);
+            this_thread::sleep_for(chrono::microseconds(100));
+        }
+    });
+    auto start = chrono::high_resolution_clock::now();
+    this_thread::sleep_for(chrono::milliseconds(200));
+    stop = true;
+    for (auto& t : threads) t.join();
+    writer.join();
+    double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+    return loads.load() / seconds;
+}
+
+void benchmarkReadMostly() {
+    cout << "Read-mostly: million loads/s over all readers, one writer every 100 us ("
+         << thread::hardware_concurrency() << " hardware threads)" << endl;
+    cout << setw(8) << "readers" << setw(14) << "slot" << setw(14) << "mutex";
+#if __cplusplus < 202002L
+    cout << setw(14) << "atomic_load";
+#endif
+#ifdef __cpp_lib_atomic_shared_ptr
+    cout << setw(14) << "atomic<sp>";
+#endif
+    cout << endl << fixed << setprecision(2);
+    for (int readers = 1; readers <= 64; readers *= 2) {
+        cout << setw(8) << readers << setw(14) << measureReads<SlotReads>(readers) / 1e6
+             << setw(14) << measureReads<MutexReads>(readers) / 1e6;
+#if __cplusplus < 202002L
+        cout << setw(14) << measureReads<AtomicFunctionReads>(readers) / 1e6;
+#endif
+#ifdef __cpp_lib_atomic_shared_ptr
+        cout << setw(14) << measureReads<StdAtomicReads>(readers) / 1e6;
+#endif
+        cout << endl;
+    }
+}
+
+// Run with --bench [ownership|refcount|slot] for the benchmarks (all of
+// them by default)
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        string only = argc > 2 ? argv[2] : "";
+        if (only.empty() || only == "ownership") {
+            benchmarkOwnership();
+            cout << endl;
+        }
+        if (only.empty() || only == "refcount") {
+            benchmarkRefCounting();
+            cout << endl;
+        }
+        if (only.empty() || only == "slot") benchmarkReadMostly();
+        return 0;
+    }
+
     cout << "===== Lock-Free Atomic Shared Pointer Test =====" << endl;
     stressTestAtomicSharedPtr();
 
     cout << "\n===== std::shared_ptr Baseline Test =====" << endl;
     stressTestStdSharedPtr();
 
+    cout << "\n===== Sharded Reference Count Test =====" << endl;
+    stressTestAtomicSharedPtr<ShardedRefCount>("Sharded");
+    testShardedRefCount();
+
+    cout << "\n===== Ownership: make_atomic_shared, Weak, Deleters =====" << endl;
+    testOwnership();
+
+    cout << "\n===== AtomicSharedSlot Concurrent Load/Store Test =====" << endl;
+    stressTestAtomicSharedSlot();
+
     return 0;
 }
 
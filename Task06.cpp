@@ -1,4 +1,3 @@
-
 /*Task 6: Concurrent Multi-Queue Producer-Consumer with Work-Stealing (Individual)
 
 Develop a producer-consumer system featuring multiple queues and efficient work-stealing.
@@ -19,7 +18,19 @@ Provide benchmarks and demonstrate balanced task distribution and improved throu
 #include <chrono>
 #include <random>
 #include <functional>
- 
+#include <algorithm>
+#include <string>
+#include <iomanip>
+#include <cstdint>
+#include <ctime>
+#include <climits>
+#include <cstdlib>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 using namespace std;
 using namespace std::chrono;
 
@@ -31,108 +42,620 @@ const int TOTAL_TASKS = 1000;
 struct Task {
     int id;
     function<void()> work;
+    steady_clock::time_point enqueued;   // set by enqueueTask, for latency
 };
 
-// Per-queue data
-struct TaskQueue {
+// === Queue backends ===
+// Every backend has the same three operations:
+//   push(task)       any thread; waits while a bounded queue is full
+//   pop(outTask)     the consumer the queue belongs to
+//   steal(outTask)   any other consumer
+// pop and steal return false when they find nothing.
+
+// The original backend: a deque behind a mutex
+struct MutexTaskQueue {
     deque<Task> tasks;
     mutex mtx;
-    condition_variable cv;
+
+    void push(Task&& task) {
+        lock_guard<mutex> lock(mtx);
+        tasks.push_back(move(task));
+    }
+
+    bool pop(Task& outTask) {
+        lock_guard<mutex> lock(mtx);
+        if (tasks.empty()) return false;
+        outTask = move(tasks.front());
+        tasks.pop_front();
+        return true;
+    }
+
+    bool steal(Task& outTask) {
+        lock_guard<mutex> lock(mtx);
+        if (tasks.empty()) return false;
+        outTask = move(tasks.back());
+        tasks.pop_back();
+        return true;
+    }
 };
 
-vector<TaskQueue> queues(NUM_QUEUES);
-atomic<int> completedTasks{0};
+// Bounded lock-free multi-producer multi-consumer ring (Vyukov). Each slot
+// has its own cache line and a sequence number saying whose turn it is:
+// sequence == position  -> free for the producer that claims 'position'
+// sequence == position+1 -> full, for the consumer that claims 'position'
+// Producers and consumers claim positions with a CAS on tail / head and
+// then own the slot until they publish the next sequence.
+template<typename T>
+class MpmcRing {
+public:
+    explicit MpmcRing(size_t capacity) : mask(capacity - 1), slots(new Slot[capacity]) {
+        // capacity must be a power of two
+        for (size_t i = 0; i < capacity; ++i) slots[i].sequence.store(i, memory_order_relaxed);
+    }
+
+    ~MpmcRing() { delete[] slots; }
+
+    MpmcRing(const MpmcRing&) = delete;
+    MpmcRing& operator=(const MpmcRing&) = delete;
 
-// Add task to a queue
-void enqueueTask(int queueId, Task task) {
-    {
-        lock_guard<mutex> lock(queues[queueId].mtx);
-        queues[queueId].tasks.push_back(task);
+    // Moves from value only on success; false when the ring is full
+    bool tryPush(T& value) {
+        size_t pos = tail.load(memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots[pos & mask];
+            size_t sequence = slot.sequence.load(memory_order_acquire);
+            intptr_t diff = intptr_t(sequence) - intptr_t(pos);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                    slot.value = move(value);
+                    slot.sequence.store(pos + 1, memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail.load(memory_order_relaxed);
+            }
+        }
     }
-    queues[queueId].cv.notify_one();
-}
 
-// Consumer tries to get task from its queue, or steal from others
-bool tryGetTask(int myId, Task& outTask) {
-    // 1. Try own queue
-    {
-        unique_lock<mutex> lock(queues[myId].mtx);
-        if (!queues[myId].tasks.empty()) {
-            outTask = queues[myId].tasks.front();
-            queues[myId].tasks.pop_front();
-            return true;
+    bool tryPop(T& out) {
+        size_t pos = head.load(memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots[pos & mask];
+            size_t sequence = slot.sequence.load(memory_order_acquire);
+            intptr_t diff = intptr_t(sequence) - intptr_t(pos + 1);
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                    out = move(slot.value);
+                    slot.sequence.store(pos + mask + 1, memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head.load(memory_order_relaxed);
+            }
         }
     }
 
-    // 2. Try stealing from others
-    for (int i = 0; i < NUM_QUEUES; ++i) {
-        if (i == myId) continue;
-        unique_lock<mutex> lock(queues[i].mtx);
-        if (!queues[i].tasks.empty()) {
-            outTask = queues[i].tasks.back();
-            queues[i].tasks.pop_back();
-            return true;
+    // A snapshot; only a hint while other threads push and pop
+    bool empty() const { return head.load(memory_order_relaxed) >= tail.load(memory_order_relaxed); }
+
+private:
+    struct alignas(64) Slot {
+        atomic<size_t> sequence;
+        T value;
+    };
+
+    const size_t mask;
+    Slot* slots;
+    alignas(64) atomic<size_t> head{0};
+    alignas(64) atomic<size_t> tail{0};
+};
+
+// Bounded Chase-Lev deque of pointers. The owner pushes and pops at the
+// bottom without a CAS unless one element is left; thieves take from the
+// top with a CAS. A thief reads a slot before it knows the element is its
+// own, so the slots hold pointers rather than the tasks themselves.
+template<typename T>
+class ChaseLevDeque {
+public:
+    explicit ChaseLevDeque(size_t capacity) : mask(capacity - 1), slots(new atomic<T*>[capacity]) {}
+    ~ChaseLevDeque() { delete[] slots; }
+
+    ChaseLevDeque(const ChaseLevDeque&) = delete;
+    ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+    // Owner only; false when full
+    bool push(T* value) {
+        int64_t b = bottom.load(memory_order_relaxed);
+        int64_t t = top.load(memory_order_acquire);
+        if (b - t > int64_t(mask)) return false;
+        slots[b & mask].store(value, memory_order_relaxed);
+        bottom.store(b + 1, memory_order_release);
+        return true;
+    }
+
+    // Owner only: the newest element, or nullptr
+    T* pop() {
+        int64_t b = bottom.load(memory_order_relaxed) - 1;
+        bottom.store(b, memory_order_seq_cst);
+        int64_t t = top.load(memory_order_seq_cst);
+        if (t > b) {
+            bottom.store(b + 1, memory_order_relaxed);
+            return nullptr;
         }
+        T* value = slots[b & mask].load(memory_order_relaxed);
+        if (t == b) {
+            // Last element: race the thieves for it
+            if (!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed)) value = nullptr;
+            bottom.store(b + 1, memory_order_relaxed);
+        }
+        return value;
+    }
+
+    // Any thread: the oldest element, or nullptr if empty or lost to
+    // another thief
+    T* steal() {
+        int64_t t = top.load(memory_order_seq_cst);
+        int64_t b = bottom.load(memory_order_seq_cst);
+        if (t >= b) return nullptr;
+        T* value = slots[t & mask].load(memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed)) return nullptr;
+        return value;
+    }
+
+private:
+    const size_t mask;
+    atomic<T*>* slots;
+    alignas(64) atomic<int64_t> top{0};
+    alignas(64) atomic<int64_t> bottom{0};
+};
+
+const size_t RING_CAPACITY = 4096;
+const size_t DEQUE_CAPACITY = 256;
+
+// Lock-free backend: one MPMC ring, FIFO for the owner and for thieves
+struct RingTaskQueue {
+    MpmcRing<Task> ring{RING_CAPACITY};
+
+    void push(Task&& task) {
+        while (!ring.tryPush(task)) this_thread::yield();
     }
+    bool pop(Task& outTask) { return ring.tryPop(outTask); }
+    bool steal(Task& outTask) { return ring.tryPop(outTask); }
+};
+
+// Owner/thief split: producers push into a lock-free inbox; the owner
+// moves a batch from the inbox into its Chase-Lev deque and pops from the
+// bottom, thieves steal from the top and then from the inbox
+struct ChaseLevTaskQueue {
+    MpmcRing<Task*> inbox{RING_CAPACITY};
+    ChaseLevDeque<Task> local{DEQUE_CAPACITY};
+
+    static const int BATCH = 32;
+
+    ~ChaseLevTaskQueue() {
+        Task* task = nullptr;
+        while ((task = local.pop())) delete task;
+        while (inbox.tryPop(task)) delete task;
+    }
+
+    void push(Task&& task) {
+        Task* boxed = new Task(move(task));
+        while (!inbox.tryPush(boxed)) this_thread::yield();
+    }
+
+    bool pop(Task& outTask) {
+        Task* task = local.pop();
+        if (!task) {
+            if (!inbox.tryPop(task)) return false;
+            // Keep one, move the rest of a batch where thieves can reach it.
+            // local is empty here and BATCH < DEQUE_CAPACITY, so push fits.
+            Task* next = nullptr;
+            for (int i = 1; i < BATCH && inbox.tryPop(next); ++i) local.push(next);
+        }
+        return unbox(task, outTask);
+    }
+
+    bool steal(Task& outTask) {
+        Task* task = local.steal();
+        if (!task && !inbox.tryPop(task)) return false;
+        return unbox(task, outTask);
+    }
+
+private:
+    static bool unbox(Task* task, Task& outTask) {
+        outTask = move(*task);
+        delete task;
+        return true;
+    }
+};
+
+// === Parking idle consumers ===
+
+// Eventcount: a consumer that found no work announces itself, checks the
+// queues once more and sleeps only if nothing changed since it announced.
+// Producers pay one fence and one load when nobody sleeps.
+//   uint32_t key = events.prepareWait();
+//   if (work or stop) events.cancelWait(); else events.wait(key);
+class EventCount {
+public:
+    uint32_t prepareWait() {
+        waiters.fetch_add(1, memory_order_seq_cst);
+        // Pairs with the fence in notify(): either the re-check after this
+        // sees the producer's task, or the producer sees this waiter
+        atomic_thread_fence(memory_order_seq_cst);
+        return epoch.load(memory_order_acquire);
+    }
+
+    void cancelWait() { waiters.fetch_sub(1, memory_order_relaxed); }
+
+    void wait(uint32_t key) {
+        while (epoch.load(memory_order_acquire) == key) sleep(key);
+        waiters.fetch_sub(1, memory_order_relaxed);
+    }
+
+    void notifyOne() { notify(false); }
+    void notifyAll() { notify(true); }
+
+private:
+    void notify(bool all) {
+        atomic_thread_fence(memory_order_seq_cst);
+        if (waiters.load(memory_order_relaxed) == 0) return;
+        epoch.fetch_add(1, memory_order_release);
+        wake(all);
+    }
+
+#ifdef __linux__
+    // Sleeps in the kernel until epoch moves on from 'key'
+    void sleep(uint32_t key) {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch), FUTEX_WAIT_PRIVATE, key, nullptr, nullptr, 0);
+    }
+    void wake(bool all) {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch), FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1, nullptr, nullptr, 0);
+    }
+#else
+    mutex mtx;
+    condition_variable cv;
+
+    void sleep(uint32_t key) {
+        unique_lock<mutex> lock(mtx);
+        cv.wait(lock, [&]() { return epoch.load(memory_order_acquire) != key; });
+    }
+    void wake(bool all) {
+        { lock_guard<mutex> lock(mtx); }
+        if (all) cv.notify_all();
+        else cv.notify_one();
+    }
+#endif
+
+    alignas(64) atomic<uint32_t> epoch{0};
+    atomic<uint32_t> waiters{0};
+};
 
-    return false;
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
 }
 
-// Producer logic
-void producerThread(int id, int numTasks) {
-    mt19937 rng(id + time(0));
-    uniform_int_distribution<> dist(0, NUM_QUEUES - 1);
+// Rounds of looking for work before a consumer parks: a task that arrives
+// within a few microseconds is picked up without a futex round trip
+const int SPIN_ROUNDS = 24;
 
-    for (int i = 0; i < numTasks; ++i) {
-        int queueId = dist(rng);
-        Task t;
-        t.id = id * 1000 + i;
-        t.work = [tid = t.id]() {
-            this_thread::sleep_for(chrono::milliseconds(5)); // simulate work
-        };
-        enqueueTask(queueId, t);
+inline void backoff(int round) {
+    if (round < 16) {
+        for (int i = 0; i < (1 << min(round, 6)); ++i) cpuRelax();
+    } else {
+        this_thread::yield();
     }
 }
 
-// Consumer logic
-void consumerThread(int id) {
-    while (true) {
-        Task t;
-        if (tryGetTask(id, t)) {
-            t.work();
-            ++completedTasks;
-        } else {
-            unique_lock<mutex> lock(queues[id].mtx);
-            queues[id].cv.wait_for(lock, chrono::milliseconds(10));
-            if (completedTasks >= TOTAL_TASKS) return;
+// How idle consumers wait:
+//   Poll: the original design, wait_for(10 ms) on the consumer's own queue
+//   Park: spin briefly, then sleep on an eventcount that any enqueue wakes
+enum class IdleMode { Poll, Park };
+
+// === Producer-consumer system over one backend ===
+template<typename Queue>
+struct TaskSystem {
+    // Per-queue wake-up for the consumer that owns it (Poll)
+    struct Signal {
+        mutex mtx;
+        condition_variable cv;
+    };
+
+    vector<Queue> queues;
+    vector<Signal> signals;
+    EventCount events;
+    const IdleMode idleMode;
+    atomic<bool> stopping{false};
+    atomic<int> completedTasks{0};
+    const int totalTasks;
+
+    // Enqueue-to-start latency per consumer, when recording
+    bool recordLatency = false;
+    vector<vector<uint32_t>> latencies;
+    atomic<int64_t> lastCompletionNs{0};
+
+    TaskSystem(int numQueues, int numConsumers, int total, IdleMode mode = IdleMode::Park)
+        : queues(numQueues), signals(numQueues), idleMode(mode), totalTasks(total), latencies(numConsumers) {}
+
+    // Add task to a queue
+    void enqueueTask(int queueId, Task task) {
+        task.enqueued = steady_clock::now();
+        queues[queueId].push(move(task));
+        if (idleMode == IdleMode::Park) events.notifyOne();
+        else signals[queueId].cv.notify_one();
+    }
+
+    // Consumers finish the tasks already queued, then exit
+    void shutdown() {
+        stopping.store(true, memory_order_release);
+        events.notifyAll();
+        for (auto& signal : signals) signal.cv.notify_all();
+    }
+
+    // Consumer tries to get task from its queue, or steal from others
+    bool tryGetTask(int myId, Task& outTask) {
+        // 1. Try own queue
+        if (myId < int(queues.size()) && queues[myId].pop(outTask)) return true;
+
+        // 2. Try stealing from others
+        for (int i = 0; i < int(queues.size()); ++i) {
+            if (i == myId) continue;
+            if (queues[i].steal(outTask)) return true;
+        }
+
+        return false;
+    }
+
+    // Producer logic: enqueues the tasks with ids firstId .. firstId + numTasks - 1
+    void producerThread(int id, int firstId, int numTasks, const function<function<void()>(int)>& makeWork) {
+        mt19937 rng(id + time(0));
+        uniform_int_distribution<> dist(0, int(queues.size()) - 1);
+
+        for (int i = 0; i < numTasks; ++i) {
+            int queueId = dist(rng);
+            Task t;
+            t.id = firstId + i;
+            t.work = makeWork(t.id);
+            enqueueTask(queueId, move(t));
+        }
+    }
+
+    void runTask(int id, Task& t) {
+        if (recordLatency) {
+            latencies[id].push_back(uint32_t(min<int64_t>(
+                duration_cast<nanoseconds>(steady_clock::now() - t.enqueued).count(), UINT32_MAX)));
+        }
+        t.work();
+        if (++completedTasks == totalTasks) {
+            lastCompletionNs = duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+            shutdown();
+        }
+    }
+
+    // Consumer logic
+    void consumerThread(int id) {
+        if (idleMode == IdleMode::Poll) {
+            pollingConsumer(id);
+            return;
+        }
+        int idleRounds = 0;
+        while (true) {
+            Task t;
+            if (tryGetTask(id, t)) {
+                runTask(id, t);
+                idleRounds = 0;
+                continue;
+            }
+            if (stopping.load(memory_order_acquire)) return;
+            if (idleRounds < SPIN_ROUNDS) {
+                backoff(idleRounds++);
+                continue;
+            }
+            uint32_t key = events.prepareWait();
+            if (tryGetTask(id, t)) {
+                events.cancelWait();
+                runTask(id, t);
+                idleRounds = 0;
+            } else if (stopping.load(memory_order_acquire)) {
+                events.cancelWait();
+                return;
+            } else {
+                events.wait(key);
+            }
+        }
+    }
+
+    // The original consumer: sleeps at most 10 ms on its own queue, so
+    // work landing elsewhere (or the end of the run) is seen late
+    void pollingConsumer(int id) {
+        int wait = id % int(signals.size());
+        while (true) {
+            Task t;
+            if (tryGetTask(id, t)) {
+                runTask(id, t);
+            } else {
+                unique_lock<mutex> lock(signals[wait].mtx);
+                signals[wait].cv.wait_for(lock, chrono::milliseconds(10));
+                if (completedTasks >= totalTasks) return;
+            }
+        }
+    }
+
+    // Runs producers and consumers to completion; returns the time from
+    // the start to the last task finishing
+    nanoseconds run(int numProducers, int numConsumers, const function<function<void()>(int)>& makeWork) {
+        auto start = steady_clock::now();
+
+        // Launch producers
+        vector<thread> producers;
+        int tasksPerProducer = totalTasks / numProducers;
+        for (int i = 0, firstId = 0; i < numProducers; ++i) {
+            int count = tasksPerProducer + (i == 0 ? totalTasks % numProducers : 0);
+            producers.emplace_back([this, i, firstId, count, &makeWork]() {
+                producerThread(i, firstId, count, makeWork);
+            });
+            firstId += count;
+        }
+
+        // Launch consumers
+        vector<thread> consumers;
+        for (int i = 0; i < numConsumers; ++i) {
+            consumers.emplace_back([this, i]() { consumerThread(i); });
+        }
+
+        for (auto& t : producers) t.join();
+        for (auto& t : consumers) t.join();
+
+        return nanoseconds(lastCompletionNs.load()) - start.time_since_epoch();
+    }
+};
+
+// Every task id must have run exactly once; anything else means a queue
+// backend lost or duplicated a task, so the run is reported and aborted
+void checkRunCounts(const char* name, const vector<atomic<int>>& runs) {
+    for (size_t id = 0; id < runs.size(); ++id) {
+        int count = runs[id].load();
+        if (count != 1) {
+            cerr << "[" << name << "] Task " << id << " ran " << count << " times, expected once\n";
+            exit(EXIT_FAILURE);
         }
     }
 }
 
-int main() {
-    cout << "Starting concurrent multi-queue producer-consumer with work-stealing...\n";
+template<typename Queue>
+void runDemo(const char* name) {
+    vector<atomic<int>> runs(TOTAL_TASKS);
+    TaskSystem<Queue> system(NUM_QUEUES, NUM_CONSUMERS, TOTAL_TASKS);
+    auto elapsed = system.run(NUM_PRODUCERS, NUM_CONSUMERS, [&runs](int id) {
+        return [&runs, id]() {
+            this_thread::sleep_for(chrono::milliseconds(5)); // simulate work
+            runs[id].fetch_add(1, memory_order_relaxed);
+        };
+    });
+    checkRunCounts(name, runs);
+    cout << "[" << name << "] All tasks completed. Time: "
+         << duration_cast<milliseconds>(elapsed).count() << " ms\n";
+}
+
+// === Benchmark ===
+// q-th percentile of latencies in ns, in microseconds
+double percentileUs(vector<uint32_t>& all, double q) {
+    if (all.empty()) return 0;
+    size_t k = min(all.size() - 1, size_t(q * all.size()));
+    nth_element(all.begin(), all.begin() + k, all.end());
+    return all[k] / 1000.0;
+}
+
+// A million empty tasks: throughput, and the time from enqueueTask to the
+// task starting on a consumer, over several producer:consumer ratios
+template<typename Queue>
+void benchmarkBackend(const char* name, int producers, int consumers) {
+    const int TASKS = 1000000;
+    vector<atomic<int>> runs(TASKS);
+    TaskSystem<Queue> system(consumers, consumers, TASKS);
+    system.recordLatency = true;
+    for (auto& l : system.latencies) l.reserve(TASKS / consumers * 2);
 
-    auto start = high_resolution_clock::now();
+    auto elapsed = system.run(producers, consumers, [&runs](int id) {
+        return [&runs, id]() { runs[id].fetch_add(1, memory_order_relaxed); };
+    });
+    checkRunCounts(name, runs);
 
-    // Launch producers
-    vector<thread> producers;
-    int tasksPerProducer = TOTAL_TASKS / NUM_PRODUCERS;
-    for (int i = 0; i < NUM_PRODUCERS; ++i) {
-        producers.emplace_back(producerThread, i, tasksPerProducer);
+    vector<uint32_t> all;
+    for (auto& l : system.latencies) all.insert(all.end(), l.begin(), l.end());
+    double p50 = percentileUs(all, 0.5), p99 = percentileUs(all, 0.99);
+    cout << "  " << left << setw(10) << name << right << fixed << setprecision(2)
+         << setw(10) << TASKS / duration<double>(elapsed).count() / 1e6 << " Mtasks/s"
+         << setw(12) << p50 << " us p50" << setw(12) << p99 << " us p99" << endl;
+}
+
+void runBenchmark() {
+    cout << "1M empty tasks, one queue per consumer (" << thread::hardware_concurrency()
+         << " hardware threads)" << endl;
+    const pair<int, int> ratios[] = {{1, 1}, {1, 4}, {4, 1}, {4, 4}};
+    for (auto ratio : ratios) {
+        cout << ratio.first << " producer(s) : " << ratio.second << " consumer(s)" << endl;
+        benchmarkBackend<MutexTaskQueue>("mutex", ratio.first, ratio.second);
+        benchmarkBackend<RingTaskQueue>("ring", ratio.first, ratio.second);
+        benchmarkBackend<ChaseLevTaskQueue>("chase-lev", ratio.first, ratio.second);
     }
+}
+
+// Idle behaviour in the demo's layout (10 queues, 5 consumers): wake-up
+// latency for single tasks arriving every 2 ms in random queues, CPU time
+// burnt over one second with no work, and how long the consumers take to
+// exit after the last task
+template<typename Queue>
+void benchmarkIdle(const char* name, IdleMode mode) {
+    const int TASKS = 200;
+    TaskSystem<Queue> system(NUM_QUEUES, NUM_CONSUMERS, TASKS + 1, mode);
+    system.recordLatency = true;
 
-    // Launch consumers
     vector<thread> consumers;
     for (int i = 0; i < NUM_CONSUMERS; ++i) {
-        consumers.emplace_back(consumerThread, i);
+        consumers.emplace_back([&system, i]() { system.consumerThread(i); });
     }
 
-    for (auto& t : producers) t.join();
+    mt19937 rng(1);
+    uniform_int_distribution<> dist(0, NUM_QUEUES - 1);
+    for (int i = 0; i < TASKS; ++i) {
+        system.enqueueTask(dist(rng), Task{i, []() {}, {}});
+        this_thread::sleep_for(chrono::milliseconds(2));
+    }
+
+    this_thread::sleep_for(chrono::milliseconds(50));
+    clock_t cpuBefore = clock();
+    auto idleStart = steady_clock::now();
+    this_thread::sleep_for(chrono::seconds(1));
+    double idleSeconds = duration<double>(steady_clock::now() - idleStart).count();
+    double cpuMsPerSecond = 1000.0 * (clock() - cpuBefore) / CLOCKS_PER_SEC / idleSeconds;
+
+    // The last task ends the run
+    system.enqueueTask(dist(rng), Task{TASKS, []() {}, {}});
     for (auto& t : consumers) t.join();
+    double exitMs = (duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count()
+                     - system.lastCompletionNs.load()) / 1e6;
+
+    vector<uint32_t> all;
+    for (auto& l : system.latencies) all.insert(all.end(), l.begin(), l.end());
+    cout << "  " << left << setw(16) << name << right << fixed << setprecision(2)
+         << setw(10) << percentileUs(all, 0.5) << setw(10) << percentileUs(all, 0.99)
+         << setw(14) << cpuMsPerSecond << setw(10) << exitMs << endl;
+}
+
+void runIdleBenchmark() {
+    cout << "Idle consumers: wake-up latency (us), idle CPU (ms per second), exit time (ms)" << endl;
+    cout << "  " << left << setw(16) << "mode" << right << setw(10) << "p50" << setw(10) << "p99"
+         << setw(14) << "idle CPU" << setw(10) << "exit" << endl;
+    benchmarkIdle<MutexTaskQueue>("mutex, poll", IdleMode::Poll);
+    benchmarkIdle<MutexTaskQueue>("mutex, park", IdleMode::Park);
+    benchmarkIdle<RingTaskQueue>("ring, park", IdleMode::Park);
+    benchmarkIdle<ChaseLevTaskQueue>("chase-lev, park", IdleMode::Park);
+}
+
+// Run with --bench [backends|idle] for the benchmarks (both by default)
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        string only = argc > 2 ? argv[2] : "";
+        if (only.empty() || only == "backends") runBenchmark();
+        if (only.empty()) cout << endl;
+        if (only.empty() || only == "idle") runIdleBenchmark();
+        return 0;
+    }
+
+    cout << "Starting concurrent multi-queue producer-consumer with work-stealing...\n";
 
-    auto end = high_resolution_clock::now();
-    cout << "All tasks completed. Time: "
-         << duration_cast<milliseconds>(end - start).count() << " ms\n";
+    runDemo<MutexTaskQueue>("mutex");
+    runDemo<RingTaskQueue>("ring");
+    runDemo<ChaseLevTaskQueue>("chase-lev");
 
     return 0;
 }
@@ -141,5 +664,7 @@ int main() {
 /*____
  Sample Output
 Starting concurrent multi-queue producer-consumer with work-stealing...
-All tasks completed. Time: 312 ms
+[mutex] All tasks completed. Time: 1012 ms
+[ring] All tasks completed. Time: 1011 ms
+[chase-lev] All tasks completed. Time: 1012 ms
 (Time varies by CPU, thread count, and task load)*/
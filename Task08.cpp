@@ -2,32 +2,47 @@
 #include <cmath>
 #include <functional>
 #include <iomanip>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+#include "WorkerPool.h"
 
 using namespace std;
 
+// The interior sums are split across a WorkerPool in chunks of a fixed
+// size, so the summation order, and the result, is the same for any
+// number of threads
+const size_t INTEGRATION_GRAIN = 1 << 16;
+
 // Trapezoidal Rule
-double trapezoidal(const function<double(double)>& f, double a, double b, int n) {
+double trapezoidal(const function<double(double)>& f, double a, double b, int n,
+                   WorkerPool& pool = sharedWorkerPool()) {
     double h = (b - a) / n;
-    double result = (f(a) + f(b)) / 2.0;
-    for (int i = 1; i < n; ++i) {
-        result += f(a + i * h);
-    }
-    return result * h;
+    double interior = pool.parallelReduce(1, size_t(n), 0.0, [&](size_t lo, size_t hi) {
+        double sum = 0.0;
+        for (size_t i = lo; i < hi; ++i) sum += f(a + i * h);
+        return sum;
+    }, plus<double>(), INTEGRATION_GRAIN);
+    return ((f(a) + f(b)) / 2.0 + interior) * h;
 }
 
 // Simpson's Rule (n must be even)
-double simpson(const function<double(double)>& f, double a, double b, int n) {
+double simpson(const function<double(double)>& f, double a, double b, int n,
+               WorkerPool& pool = sharedWorkerPool()) {
     if (n % 2 != 0) {
         cerr << "Simpson's rule requires even n. Increasing n by 1." << endl;
         ++n;
     }
     double h = (b - a) / n;
-    double result = f(a) + f(b);
-    for (int i = 1; i < n; ++i) {
-        double x = a + i * h;
-        result += (i % 2 == 0 ? 2 : 4) * f(x);
-    }
-    return result * h / 3.0;
+    double interior = pool.parallelReduce(1, size_t(n), 0.0, [&](size_t lo, size_t hi) {
+        double sum = 0.0;
+        for (size_t i = lo; i < hi; ++i) sum += (i % 2 == 0 ? 2 : 4) * f(a + i * h);
+        return sum;
+    }, plus<double>(), INTEGRATION_GRAIN);
+    return (f(a) + f(b) + interior) * h / 3.0;
 }
 
 // Test functions
@@ -66,8 +81,46 @@ void testIntegration() {
     cout << "Analytical:  0.38629436\n";
 }
 
-int main() {
+// Strong scaling of both rules on exp(-x^2) over [0, 1]
+void benchmarkScaling(size_t maxThreads) {
+    const int n = 20000000;
+    vector<size_t> counts;
+    for (size_t t = 1; t < maxThreads; t *= 2) counts.push_back(t);
+    counts.push_back(maxThreads);
+
+    cout << "Strong scaling, exp(-x^2) on [0, 1], n = " << n << "\n";
+    cout << "threads | trapezoidal ms  speedup | simpson ms  speedup | trapezoidal, simpson\n";
+    double trapBase = 0, simpBase = 0;
+    for (size_t t : counts) {
+        WorkerPool pool(t - 1);
+        auto t0 = chrono::high_resolution_clock::now();
+        double trap = trapezoidal(f3, 0.0, 1.0, n, pool);
+        auto t1 = chrono::high_resolution_clock::now();
+        double simp = simpson(f3, 0.0, 1.0, n, pool);
+        auto t2 = chrono::high_resolution_clock::now();
+        double trapMs = chrono::duration<double, milli>(t1 - t0).count();
+        double simpMs = chrono::duration<double, milli>(t2 - t1).count();
+        if (t == 1) { trapBase = trapMs; simpBase = simpMs; }
+        cout << setw(7) << t << " | " << setw(14) << setprecision(1) << trapMs << "  " << setw(7)
+             << setprecision(2) << trapBase / trapMs << " | " << setw(10) << setprecision(1) << simpMs
+             << "  " << setw(7) << setprecision(2) << simpBase / simpMs << " | " << setprecision(12)
+             << trap << ", " << simp << "\n";
+    }
+}
+
+// Run with --scaling [max_threads] for the multithreaded benchmark
+int main(int argc, char** argv) {
+    if (argc > 1 && string(argv[1]) == "--scaling") {
+        size_t threads = argc > 2 ? stoul(argv[2]) : max(1u, thread::hardware_concurrency());
+        cout << fixed;
+        benchmarkScaling(max<size_t>(1, threads));
+        return 0;
+    }
     testIntegration();
+
+    cout << "\nParallel (" << sharedWorkerPool().concurrency() << " threads), n = 1000000:\n";
+    cout << "Trapezoidal, exp(-x^2): " << trapezoidal(f3, 0.0, 1.0, 1000000) << endl;
+    cout << "Simpson, exp(-x^2):     " << simpson(f3, 0.0, 1.0, 1000000) << endl;
     return 0;
 }
 
@@ -8,24 +8,38 @@ Clearly demonstrate accuracy with results from various sample sizes.*/
 #include <random>
 #include <iomanip>
 #include <cmath>
+#include <vector>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+#include <string>
 
-using namespace std;
+#include "WorkerPool.h"
 
-// Estimate pi using Monte Carlo method
-double estimatePi(unsigned int numSamples) {
-    random_device rd;  // Non-deterministic generator
-    mt19937 gen(rd()); // Mersenne Twister engine
-    uniform_real_distribution<> dis(0.0, 1.0);
+using namespace std;
 
-    unsigned int insideCircle = 0;
+// Estimate pi using Monte Carlo method. The samples are split into fixed
+// chunks across a WorkerPool, and each chunk seeds its own generator from
+// (seed, chunk index), so a given seed gives the same estimate for any
+// number of threads.
+const size_t SAMPLES_PER_CHUNK = 1 << 20;
 
-    for (unsigned int i = 0; i < numSamples; ++i) {
-        double x = dis(gen);
-        double y = dis(gen);
+double estimatePi(size_t numSamples, unsigned seed = random_device{}(), WorkerPool& pool = sharedWorkerPool()) {
+    size_t insideCircle = pool.parallelReduce(0, numSamples, size_t(0), [seed](size_t lo, size_t hi) {
+        seed_seq seq{seed, unsigned(lo / SAMPLES_PER_CHUNK)};
+        mt19937 gen(seq); // Mersenne Twister engine
+        uniform_real_distribution<> dis(0.0, 1.0);
+        size_t inside = 0;
+        for (size_t i = lo; i < hi; ++i) {
+            double x = dis(gen);
+            double y = dis(gen);
 
-        if (x * x + y * y <= 1.0)
-            ++insideCircle;
-    }
+            if (x * x + y * y <= 1.0)
+                ++inside;
+        }
+        return inside;
+    }, plus<size_t>(), SAMPLES_PER_CHUNK);
 
     return 4.0 * insideCircle / numSamples;
 }
@@ -40,9 +54,45 @@ void testMonteCarlo() {
              << " | Pi ≈ " << piEstimate
              << " | Error: " << fabs(M_PI - piEstimate) << endl;
     }
+
+    const size_t n = 10000000;
+    double piEstimate = estimatePi(n);
+    cout << "Samples: " << setw(8) << n
+         << " | Pi ≈ " << piEstimate
+         << " | Error: " << fabs(M_PI - piEstimate)
+         << "  (" << sharedWorkerPool().concurrency() << " threads)" << endl;
 }
 
-int main() {
+// Strong scaling of the estimator at a fixed seed
+void benchmarkScaling(size_t maxThreads) {
+    const size_t n = 50000000;
+    vector<size_t> counts;
+    for (size_t t = 1; t < maxThreads; t *= 2) counts.push_back(t);
+    counts.push_back(maxThreads);
+
+    cout << "Strong scaling, " << n << " samples, seed 42\n";
+    cout << "threads |    ms     speedup  Msamples/s | Pi estimate\n";
+    double base = 0;
+    for (size_t t : counts) {
+        WorkerPool pool(t - 1);
+        auto start = chrono::high_resolution_clock::now();
+        double piEstimate = estimatePi(n, 42, pool);
+        double ms = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+        if (t == 1) base = ms;
+        cout << setw(7) << t << " | " << setprecision(1) << setw(7) << ms << "  " << setprecision(2)
+             << setw(8) << base / ms << "  " << setw(10) << n / ms * 1e-3 << " | " << setprecision(8)
+             << piEstimate << "\n";
+    }
+}
+
+// Run with --scaling [max_threads] for the multithreaded benchmark
+int main(int argc, char** argv) {
+    if (argc > 1 && string(argv[1]) == "--scaling") {
+        size_t threads = argc > 2 ? stoul(argv[2]) : max(1u, thread::hardware_concurrency());
+        cout << fixed;
+        benchmarkScaling(max<size_t>(1, threads));
+        return 0;
+    }
     testMonteCarlo();
     return 0;
 }
@@ -0,0 +1,150 @@
+// WorkerPool.h - fork-join pool shared by Tasks 1, 8 and 10
+//
+// Mutex + condition_variable pool, trimmed down from the Task 3 ThreadPool,
+// with parallelFor, parallelForRange (Task 1's element-wise loops) and
+// parallelReduce (Task 8's integration rules, Task 10's estimator). The
+// caller always takes part in a loop, so nested loops cannot deadlock it.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class WorkerPool {
+public:
+    // 'helpers' background threads; the caller is the extra participant
+    explicit WorkerPool(size_t helpers) : stop(false) {
+        for (size_t i = 0; i < helpers; ++i) {
+            workers.emplace_back([this] {
+                while (true) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(queue_mutex);
+                        condition.wait(lock, [this] { return stop || !tasks.empty(); });
+                        if (stop && tasks.empty()) return;
+                        task = std::move(tasks.front());
+                        tasks.pop();
+                    }
+                    task();
+                }
+            });
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            stop = true;
+        }
+        condition.notify_all();
+        for (std::thread& t : workers) t.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Threads that can work on one parallelFor, including the caller
+    size_t concurrency() const { return workers.size() + 1; }
+
+    // Runs body(0) .. body(count - 1), handing indices out dynamically.
+    // Returns once every index is done; the first exception is rethrown.
+    template<typename F>
+    void parallelFor(size_t count, F&& body) {
+        if (count == 0) return;
+        if (workers.empty() || count == 1) {
+            for (size_t i = 0; i < count; ++i) body(i);
+            return;
+        }
+
+        struct Region {
+            std::function<void(size_t)> body;
+            size_t count;
+            std::atomic<size_t> next{0}, finished{0};
+            std::mutex m;
+            std::condition_variable done;
+            std::exception_ptr error;
+        };
+        auto region = std::make_shared<Region>();
+        region->body = body;
+        region->count = count;
+
+        auto runner = [region] {
+            size_t i;
+            while ((i = region->next.fetch_add(1)) < region->count) {
+                try {
+                    region->body(i);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(region->m);
+                    if (!region->error) region->error = std::current_exception();
+                }
+                if (region->finished.fetch_add(1) + 1 == region->count) {
+                    std::lock_guard<std::mutex> lock(region->m);
+                    region->done.notify_all();
+                }
+            }
+        };
+
+        size_t helpers = std::min(workers.size(), count - 1);
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            for (size_t h = 0; h < helpers; ++h) tasks.emplace(runner);
+        }
+        if (helpers == 1) condition.notify_one();
+        else condition.notify_all();
+
+        runner();
+        std::unique_lock<std::mutex> lock(region->m);
+        region->done.wait(lock, [&] { return region->finished.load() == region->count; });
+        if (region->error) std::rethrow_exception(region->error);
+    }
+
+    // body(lo, hi) over chunks of [begin, end). grain = 0 picks about four
+    // chunks per participant, like Task 3's parallelForRange.
+    template<typename F>
+    void parallelForRange(size_t begin, size_t end, F&& body, size_t grain = 0) {
+        if (begin >= end) return;
+        const size_t n = end - begin;
+        if (grain == 0) grain = std::max<size_t>(1, n / (4 * concurrency()));
+        const size_t chunks = (n + grain - 1) / grain;
+        parallelFor(chunks, [&](size_t c) {
+            body(begin + c * grain, std::min(end, begin + (c + 1) * grain));
+        });
+    }
+
+    // Cuts [begin, end) into chunks of 'grain'; body(lo, hi) returns one
+    // chunk's value and the values are folded in chunk order, so the result
+    // depends only on the grain, not on the threads or the scheduling
+    template<typename T, typename F, typename Combine>
+    T parallelReduce(size_t begin, size_t end, T identity, F&& body, Combine&& combine, size_t grain) {
+        if (begin >= end) return identity;
+        grain = std::max<size_t>(1, grain);
+        const size_t chunks = (end - begin + grain - 1) / grain;
+        std::vector<T> partial(chunks, identity);
+        parallelFor(chunks, [&](size_t c) {
+            partial[c] = body(begin + c * grain, std::min(end, begin + (c + 1) * grain));
+        });
+        T result = identity;
+        for (const T& p : partial) result = combine(result, p);
+        return result;
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex queue_mutex;
+    std::condition_variable condition;
+    bool stop;
+};
+
+// Process-wide pool, one participant per hardware thread
+inline WorkerPool& sharedWorkerPool() {
+    static WorkerPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}